@@ -79,6 +79,24 @@ static inline void eb_set(uint16_t address, unsigned char value)
     _eb_memory[address * 2] = value;
 }
 
+/// @brief set a 16 bit value, little endian as the 6502 reads it
+/// @param address the 6502 address
+/// @param value the new value
+static inline void eb_set16(uint16_t address, uint16_t value)
+{
+    eb_set(address, value);
+    eb_set(address + 1, value >> 8);
+}
+
+/// @brief set a 32 bit value, little endian as the 6502 reads it
+/// @param address the 6502 address
+/// @param value the new value
+static inline void eb_set32(uint16_t address, uint32_t value)
+{
+    eb_set16(address, value);
+    eb_set16(address + 2, value >> 16);
+}
+
 /// @brief get a string of chars
 /// @param buffer destination buffer
 /// @param size number of chars to get
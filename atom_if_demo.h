@@ -38,15 +38,29 @@ double estimate_pi(int count)
 
 volatile bool vdu_updated_flag = false;
 volatile bool sid_updated_flag = false;
+volatile bool stats_select_flag = false;
+volatile bool blit_start_flag = false;
 
+// Bus events handled, and the most handled by one interrupt which is the deepest the
+// event queue has been since print_stats() last reset it
+volatile uint32_t bus_events = 0;
+volatile uint32_t bus_queue_max = 0;
+
+
+void sprite_write(uint16_t address);
+void draw_write(uint16_t address);
+void ext_write(uint16_t address);
+void ext_select();
 
 void handler()
 {
     dma_hw->ints1 = 1u << eb_get_event_chan();
     
+    uint32_t events = 0;
     int address = eb_get_event();
     while (address > 0)
     {
+        events++;
         if (address == YARRB_REG0)
         {
             if ((eb_get(YARRB_REG0) & YARRB_4MHZ) && (watchdog_hw->scratch[0] != EB_65C02_MAGIC_NUMBER))
@@ -59,16 +73,45 @@ void handler()
                 watchdog_enable(0, true);
             }
         }
-        if (address >= FB_ADDR && address < FB_ADDR + 0x1800)
+        if (address >= FB_ADDR && address < FB_ADDR + VGA80_MEM_SIZE)
         {
             vdu_updated_flag = true;
         }
+        else if (address >= EXT_WINDOW && address < EXT_WINDOW + EXT_WINDOW_SIZE)
+        {
+            ext_write(address);
+        }
+        else if (address == EXT_BANK)
+        {
+            ext_select();
+        }
         else if (address >= SID_BASE_ADDR && address < SID_BASE_ADDR + SID_LEN)
         {
             sid_updated_flag = true;
         }
+        else if (address == STATS_SELECT)
+        {
+            stats_select_flag = true;
+        }
+        else if (address == BLIT_STATUS)
+        {
+            blit_start_flag = eb_get(BLIT_STATUS) & BLIT_START;
+        }
+        else if (address >= DRAW_BASE && address < DRAW_BASE + DRAW_LEN)
+        {
+            draw_write(address);
+        }
+        else if (address >= SPRITE_BASE && address < SPRITE_BASE + SPRITE_LEN)
+        {
+            sprite_write(address);
+        }
         address = eb_get_event();
     }
+    bus_events += events;
+    if (events > bus_queue_max)
+    {
+        bus_queue_max = events;
+    }
 }
 
 static bool vdu_updated()
@@ -89,6 +132,24 @@ static bool sid_updated()
     return result;
 }
 
+static bool stats_selected()
+{
+    irq_set_enabled(DMA_IRQ_1, false);
+    bool result = stats_select_flag;
+    stats_select_flag = false;
+    irq_set_enabled(DMA_IRQ_1, true);
+    return result;
+}
+
+static bool blit_started()
+{
+    irq_set_enabled(DMA_IRQ_1, false);
+    bool result = blit_start_flag;
+    blit_start_flag = false;
+    irq_set_enabled(DMA_IRQ_1, true);
+    return result;
+}
+
 static void demo_init()
 {
     eb_set_perm(0xA00, EB_PERM_READ_WRITE, 0x100);
@@ -118,6 +179,26 @@ static void atom_to_ascii(char *atom, int len)
 int get_mode();
 void print_screen(bool);
 void print_sid();
+void print_stats();
+void update_stats_regs();
+void blit_run();
+bool draw_pending();
+void draw_run();
+bool frame_started();
+void frame_tasks();
+void render_idle();
+void set_perf_text(uint row, const char *text);
+
+extern volatile uint16_t scanline_words_max;
+extern volatile render_load_t render_load[2];
+extern volatile uint32_t dropped_lines;
+extern volatile render_hist_t render_hist[2];
+extern bool perf;
+#if (RENDER_GOVERNOR == 1)
+extern volatile uint governor_level;
+extern volatile governor_event_t governor_log[GOVERNOR_LOG_LEN];
+extern volatile uint32_t governor_changes;
+#endif
 
 void demo_loop()
 {
@@ -130,9 +211,14 @@ void demo_loop()
     irq_set_exclusive_handler(DMA_IRQ_1, handler);
     irq_set_enabled(DMA_IRQ_1, true);
     dma_hw->ints1 = 1u << eb_get_event_chan();
+    uint32_t last_stats = time_us_32();
     for (;;)
     {
-        __wfi();
+        render_idle();
+        if (frame_started())
+        {
+            frame_tasks();
+        }
         if (vdu_updated())
         {
             print_screen(false);
@@ -141,6 +227,23 @@ void demo_loop()
         {
             print_sid();
         }
+        if (stats_selected())
+        {
+            update_stats_regs();
+        }
+        if (blit_started())
+        {
+            blit_run();
+        }
+        if (draw_pending())
+        {
+            draw_run();
+        }
+        if (time_us_32() - last_stats >= 1000000)
+        {
+            last_stats = time_us_32();
+            print_stats();
+        }
     }
 }
 
@@ -206,4 +309,215 @@ void print_sid()
         puts("");
     }
     show_cursor();
-}
\ No newline at end of file
+}
+
+static const char *render_path_names[RENDER_PATHS] = {
+    "Border",
+    "Text",
+    "Graphics",
+    "Artifact",
+    "80 col",
+    "80 attr",
+    "Bitmap",
+};
+
+// Render time histograms of both cores, the totals when print_stats() last ran and the
+// counts for the second before that
+static uint32_t hist_total[RENDER_PATHS][RENDER_HIST_BUCKETS];
+static uint16_t hist_second[RENDER_PATHS][RENDER_HIST_BUCKETS];
+
+static void update_render_hist()
+{
+    for (int path = 0; path < RENDER_PATHS; path++)
+    {
+        for (int bucket = 0; bucket < RENDER_HIST_BUCKETS; bucket++)
+        {
+            uint32_t total = render_hist[0].count[path][bucket] + render_hist[1].count[path][bucket];
+            uint32_t count = total - hist_total[path][bucket];
+            hist_total[path][bucket] = total;
+            hist_second[path][bucket] = (count > UINT16_MAX) ? UINT16_MAX : count;
+        }
+    }
+}
+
+static uint32_t render_max_us(int path)
+{
+    uint32_t max0 = render_hist[0].max_us[path];
+    uint32_t max1 = render_hist[1].max_us[path];
+    return (max0 > max1) ? max0 : max1;
+}
+
+/// @brief copy the statistics of the render path selected by the 6502 to the registers
+void update_stats_regs()
+{
+    uint8_t select = eb_get(STATS_SELECT);
+    if (select & 0x80)
+    {
+        memset((void *)render_hist, 0, sizeof(render_hist));
+        memset(hist_total, 0, sizeof(hist_total));
+        memset(hist_second, 0, sizeof(hist_second));
+        select &= 0x7F;
+        eb_set(STATS_SELECT, select);
+    }
+    int path = (select < RENDER_PATHS) ? select : 0;
+
+    uint32_t lines = 0;
+    for (int bucket = 0; bucket < RENDER_HIST_BUCKETS; bucket++)
+    {
+        eb_set16(STATS_HIST + bucket * 2, hist_second[path][bucket]);
+        lines += hist_second[path][bucket];
+    }
+    uint32_t max_us = render_max_us(path);
+    eb_set(STATS_PATHS, RENDER_PATHS);
+    eb_set(STATS_BUCKET_US, RENDER_HIST_US);
+    eb_set(STATS_BUCKETS, RENDER_HIST_BUCKETS);
+    eb_set32(STATS_DROPPED, dropped_lines);
+    eb_set32(STATS_LATE, render_load[0].late + render_load[1].late);
+    eb_set16(STATS_LINES, (lines > UINT16_MAX) ? UINT16_MAX : lines);
+    eb_set16(STATS_MAX_US, (max_us > UINT16_MAX) ? UINT16_MAX : max_us);
+}
+
+// Print the render time histograms for the last second, one row for each path
+static void print_render_hist()
+{
+    printf("us       max");
+    for (int bucket = 0; bucket < RENDER_HIST_BUCKETS; bucket++)
+    {
+        printf(" %4d%c", bucket * RENDER_HIST_US, (bucket == RENDER_HIST_BUCKETS - 1) ? '+' : ' ');
+    }
+    puts("");
+    for (int path = 0; path < RENDER_PATHS; path++)
+    {
+        printf("%-8s %3lu", render_path_names[path], (unsigned long)render_max_us(path));
+        for (int bucket = 0; bucket < RENDER_HIST_BUCKETS; bucket++)
+        {
+            printf(" %5u", hist_second[path][bucket]);
+        }
+        puts("");
+    }
+}
+
+#if (RENDER_GOVERNOR == 1)
+static const char *governor_level_names[GOV_LEVELS] = {
+    "full",
+    "no overlay",
+    "plain artifact",
+    "line repeat",
+};
+
+// Print the governor's level and its last few changes, newest first
+static void print_governor()
+{
+    uint32_t changes = governor_changes;
+    printf("Governor %-14s %6lu changes\n", governor_level_names[governor_level], (unsigned long)changes);
+    for (uint32_t i = 0; i < GOVERNOR_LOG_LEN; i++)
+    {
+        if (i < changes)
+        {
+            governor_event_t event = governor_log[(changes - 1 - i) % GOVERNOR_LOG_LEN];
+            printf("  frame %8lu %-14s -> %-14s debt %5uus dropped %3u\n",
+                   (unsigned long)event.frame,
+                   governor_level_names[event.from],
+                   governor_level_names[event.to],
+                   event.debt_us,
+                   event.dropped);
+        }
+        else
+        {
+            printf("%78s\n", "");
+        }
+    }
+}
+#endif
+
+static unsigned long percent(uint32_t us, uint32_t elapsed)
+{
+    return (unsigned long)((uint64_t)us * 100 / elapsed);
+}
+
+/// @brief print the scanline buffer high water mark, the rendering load on each core and
+/// the performance counters since the last call, and update the performance overlay
+void print_stats()
+{
+    static uint32_t last_us = 0;
+    static render_load_t last_load[2];
+    static uint32_t last_dropped = 0;
+    static uint32_t last_events = 0;
+    static uint32_t last_sc_busy_us = 0;
+
+    uint32_t now = time_us_32();
+    uint32_t elapsed = now - last_us;
+    last_us = now;
+
+    hide_cursor();
+    printf("\e[26;1H");
+    printf("Scanline words max %4d of %d\n", scanline_words_max, PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS);
+    uint32_t total_busy = 0;
+    uint32_t total_lines = 0;
+    uint32_t total_late = 0;
+    uint32_t total_osd = 0;
+    for (int core = 0; core < 2; core++)
+    {
+        render_load_t load = render_load[core];
+        uint32_t busy = load.busy_us - last_load[core].busy_us;
+        uint32_t lines = load.lines - last_load[core].lines;
+        uint32_t late = load.late - last_load[core].late;
+        uint32_t osd = load.osd_us - last_load[core].osd_us;
+        last_load[core] = load;
+        printf("Core%d render %3lu%% %6lu lines/s %5lu late overlay %2lu%%\n",
+               core,
+               percent(busy, elapsed),
+               (unsigned long)((uint64_t)lines * 1000000 / elapsed),
+               (unsigned long)late,
+               percent(osd, elapsed));
+        total_busy += busy;
+        total_lines += lines;
+        total_late += late;
+        total_osd += osd;
+    }
+
+    uint32_t dropped = dropped_lines - last_dropped;
+    last_dropped += dropped;
+
+    irq_set_enabled(DMA_IRQ_1, false);
+    uint32_t events = bus_events - last_events;
+    last_events += events;
+    uint32_t queue_max = bus_queue_max;
+    bus_queue_max = 0;
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    uint32_t sc_busy = sc_busy_us - last_sc_busy_us;
+    last_sc_busy_us += sc_busy;
+
+    // Render time per line in tenths of a microsecond
+    uint32_t line_time = total_lines ? total_busy * 10 / total_lines : 0;
+    printf("Dropped %5lu bus events %7lu/s queue max %3lu audio %2lu%%\n",
+           (unsigned long)dropped,
+           (unsigned long)((uint64_t)events * 1000000 / elapsed),
+           (unsigned long)queue_max,
+           percent(sc_busy, elapsed));
+    update_render_hist();
+    print_render_hist();
+#if (RENDER_GOVERNOR == 1)
+    print_governor();
+#endif
+    show_cursor();
+    update_stats_regs();
+
+    if (perf)
+    {
+        char text[80];
+        snprintf(text, sizeof(text), "LINE %lu.%luUS LATE %lu DROP %lu",
+                 (unsigned long)line_time / 10,
+                 (unsigned long)line_time % 10,
+                 (unsigned long)total_late,
+                 (unsigned long)dropped);
+        set_perf_text(0, text);
+        snprintf(text, sizeof(text), "BUS %lu/S Q %lu SND %lu%% OSD %lu%%",
+                 (unsigned long)((uint64_t)events * 1000000 / elapsed),
+                 (unsigned long)queue_max,
+                 percent(sc_busy, elapsed),
+                 percent(total_osd, elapsed));
+        set_perf_text(1, text);
+    }
+}
@@ -27,7 +27,12 @@
 
 #include "hardware/irq.h"
 #include "hardware/vreg.h"
+#include "hardware/interp.h"
 #include "atomvga.h"
+#if (RENDER_BENCH == 1)
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#endif
 #include "fonts.h"
 #include "platform.h"
 #if (PLATFORM == PLATFORM_DRAGON)
@@ -43,7 +48,7 @@
 //static PIO pio = pio1;
 // static uint8_t *fontdata = fontdata_6847;
 
-static uint32_t vga80_lut[128 * 4];
+static uint32_t vga80_lut[2][128 * 4];
 
 volatile uint8_t fontno = DEFAULT_FONT;
 volatile uint8_t max_lower = LOWER_END;
@@ -70,6 +75,8 @@ void reset_vga80();
 
 void core1_func();
 
+void render_bench();
+
 static semaphore_t video_initted;
 
 bool updated;
@@ -101,9 +108,9 @@ static inline bool alt_colour()
 #endif
 }
 
-inline bool is_artifact(uint mode)
+static inline bool is_artifact(uint mode, uint art)
 {
-    return ((0 != artifact) && (0x0F == mode)) ? true : false;
+    return ((0 != art) && (0x0F == mode)) ? true : false;
 }
 
 // Treat artifacted pmode 4 as pmode 3 with a different palette
@@ -116,18 +123,24 @@ const uint debug_text_len = 32;
 char debug_text[33];
 bool debug = false;
 
-void set_debug_text(char *text)
+// Performance overlay, the two rows are set by print_stats() once a second
+bool perf = false;
+char perf_text[2][33];
+
+// Copy text to a 32 character line, padded with spaces, converted to VDG characters
+static void to_vdg_text(char *line, const char *text)
 {
-    strncpy(debug_text, text, debug_text_len);
+    size_t len = strnlen(text, debug_text_len);
+    memcpy(line, text, len);
 
-    for (unsigned int i = strnlen(text, debug_text_len); i < debug_text_len; i++)
+    for (unsigned int i = len; i < debug_text_len; i++)
     {
-        debug_text[i] = ' ';
+        line[i] = ' ';
     }
 
     for (unsigned int i = 0; i < debug_text_len; i++)
     {
-        unsigned char c = debug_text[i];
+        unsigned char c = line[i];
 
 #if (PLATFORM == PLATFORM_ATOM)
         c = c + 0x20;
@@ -145,10 +158,20 @@ void set_debug_text(char *text)
             c = c - 0x60;
         }
 #endif
-        debug_text[i] = c;
+        line[i] = c;
     }
 }
 
+void set_debug_text(char *text)
+{
+    to_vdg_text(debug_text, text);
+}
+
+void set_perf_text(uint row, const char *text)
+{
+    to_vdg_text(perf_text[row], text);
+}
+
 #define DEBUG_BUF_SIZE 80
 
 void update_debug_text()
@@ -234,6 +257,32 @@ bool uint8_param(char *params,
 
 #endif
 
+// The selected font and COPPER_FONT's second font, copied out of flash by latch_font()
+// so glyph fetches during scanout never go through the XIP cache. There's a pair for
+// each frame parity, so recaching one for the next frame can't tear the frame the other
+// core is still drawing. Fonts with fewer than 128 characters are padded with blank
+// glyphs.
+//
+// The cache is scanline major: row r of every glyph is in the 128 byte plane
+// font_cache[p][f][r], so each scanline reads from a single plane rather than striding
+// through the font 12 bytes at a time.
+static uint8_t font_cache[2][2][FONT_ROWS][FONT_CHARS];
+static uint cached_font[2][2] = {{UINT32_MAX, UINT32_MAX}, {UINT32_MAX, UINT32_MAX}};
+
+// Transpose the glyph major font data into planes
+static void cache_font(uint8_t cache[FONT_ROWS][FONT_CHARS], uint font_no)
+{
+    const font_t *font = &fonts[font_no];
+    uint chars = MIN(font->size / FONT_ROWS, FONT_CHARS);
+    for (uint row = 0; row < FONT_ROWS; row++)
+    {
+        for (uint ch = 0; ch < FONT_CHARS; ch++)
+        {
+            cache[row][ch] = (ch < chars) ? font->fontdata[ch * FONT_ROWS + row] : 0;
+        }
+    }
+}
+
 void switch_font(uint8_t new_font)
 {
     uint8_t font_range;
@@ -375,6 +424,34 @@ void print_str(int line_num, char *str)
     eb_set_chars(GetVidMemBase() + 0x020 * line_num, debug_text, 32);
 }
 
+// Set which addresses the 6502 can read and write
+void set_bus_perms()
+{
+    eb_set_perm(0, EB_PERM_NO_ACCESS, 0x10000);
+    eb_set_perm(FB_ADDR, (SERVE_VIDEO_RAM == 1) ? EB_PERM_READ_WRITE : EB_PERM_WRITE_ONLY, VGA80_MEM_SIZE);
+    eb_set_perm(COL80_BASE, EB_PERM_READ_WRITE, 16);
+    eb_set_perm_byte(PAGE_DISPLAY, EB_PERM_READ_WRITE);
+    eb_set_perm_byte(PAGE_SHOWN, EB_PERM_READ_ONLY);
+    eb_set_perm(RASTER_BASE, EB_PERM_READ_ONLY, RASTER_LEN);
+    eb_set_perm(COPPER_BASE, EB_PERM_READ_WRITE, COPPER_LEN);
+    eb_set_perm_byte(COPPER_CTRL, EB_PERM_READ_WRITE);
+    eb_set_perm(SPRITE_BASE, EB_PERM_READ_WRITE, SPRITE_LEN);
+    eb_set_perm_byte(SPRITE_HITS, EB_PERM_READ_ONLY);
+    eb_set_perm(BLIT_BASE, EB_PERM_READ_WRITE, BLIT_LEN);
+    eb_set_perm(DRAW_BASE, EB_PERM_READ_WRITE, DRAW_LEN);
+    eb_set_perm(DRAW_RING, EB_PERM_READ_WRITE, DRAW_RING_LEN);
+    eb_set_perm_byte(DRAW_TAIL, EB_PERM_READ_ONLY);
+    eb_set_perm(EXT_WINDOW, EB_PERM_READ_WRITE, EXT_WINDOW_SIZE);
+    eb_set_perm_byte(EXT_BANK, EB_PERM_READ_WRITE);
+    eb_set_perm_byte(EXT_CTRL, EB_PERM_READ_WRITE);
+    eb_set_perm(PALETTE_BASE, EB_PERM_READ_WRITE, PALETTE_LEN);
+    eb_set_perm_byte(PIA_ADDR, EB_PERM_WRITE_ONLY);
+    eb_set_perm_byte(STATS_SELECT, EB_PERM_READ_WRITE);
+    eb_set_perm(STATS_SELECT + 1, EB_PERM_READ_ONLY, STATS_LEN - 1);
+
+    demo_init();
+}
+
 int main(void)
 {
     uint sys_freq = 250000;
@@ -386,6 +463,9 @@ int main(void)
     stdout_uart_init();
     puts("Atom Pico VGA DMA " __DATE__ " " __TIME__);
     switch_font(DEFAULT_FONT);
+#if (RENDER_BENCH == 1)
+    render_bench();
+#endif
 
 #if (PLATFORM == PLATFORM_DRAGON)
     init_ee();
@@ -426,19 +506,14 @@ int main(void)
     // // wait for initialization of video to be complete
     sem_acquire_blocking(&video_initted);
 
-    // set read and write permissions
-    eb_set_perm(0, EB_PERM_NO_ACCESS, 0x10000);
-    eb_set_perm(FB_ADDR, EB_PERM_WRITE_ONLY, VID_MEM_SIZE);
-    eb_set_perm(COL80_BASE, EB_PERM_READ_WRITE, 16);
-    eb_set_perm_byte(PIA_ADDR, EB_PERM_WRITE_ONLY);
-
-    demo_init();
+    set_bus_perms();
 
 
     // start the DMA interface on PIO1
     eb_init(pio1);
 
     demo_loop();
+    return 0;
 }
 
 #if (PLATFORM == PLATFORM_ATOM)
@@ -457,6 +532,16 @@ void check_command()
         debug = false;
         ClearCommand();
     }
+    else if (is_command("PERF", &params))
+    {
+        perf = true;
+        ClearCommand();
+    }
+    else if (is_command("NOPERF", &params))
+    {
+        perf = false;
+        ClearCommand();
+    }
     else if (is_command("LOWER", &params))
     {
         support_lower = true;
@@ -569,6 +654,12 @@ void check_command()
         case DRAGON_CMD_NODEBUG:
             debug = false;
             break;
+        case DRAGON_CMD_PERF:
+            perf = true;
+            break;
+        case DRAGON_CMD_NOPERF:
+            perf = false;
+            break;
         case DRAGON_CMD_LOWER:
             support_lower = true;
             break;
@@ -622,576 +713,2952 @@ void check_reset(void)
     }
 }
 
-const uint chars_per_row = 32;
-
-const uint vga_width = 640;
-const uint vga_height = 480;
+// Set by begin_frame() at the start of each frame, see frame_tasks()
+static volatile bool frame_start_flag = false;
 
-const uint max_width = 512;
-const uint max_height = 384;
+bool frame_started()
+{
+    bool result = frame_start_flag;
+    frame_start_flag = false;
+    return result;
+}
 
-const uint vertical_offset = (vga_height - max_height) / 2;
-const uint horizontal_offset = (vga_width - max_width) / 2;
+// Once a frame housekeeping, run by core0 rather than the renderers as the commands
+// can print and on the Dragon write the EEPROM
+void frame_tasks()
+{
+    check_command();
+    update_debug_text();
+    check_reset();
+}
 
-const uint debug_start = max_height + vertical_offset;
+// Blitter, see BLIT_BASE. Run by core0 when the 6502 writes BLIT_START.
 
-uint16_t *add_border(uint16_t *p, uint16_t border_colour, uint16_t len)
+// Video memory includes the 80x40 attribute mode's attributes, as set_bus_perms() does
+static inline bool in_video_memory(uint16_t address)
 {
-    *p++ = COMPOSABLE_COLOR_RUN;
-    *p++ = border_colour;
-    *p++ = len - 3;
-    return p;
+    return address >= GetVidMemBase() && address < GetVidMemBase() + VGA80_MEM_SIZE;
 }
 
-// Process Text mode, Semigraphics modes.
-//
-// 6847 control Atom    Dragon
-// INV          D7      D6
-// !A/G         PA4     PB7
-// !A/S         D6      D7
-// CSS          PC3     PB3
-// !INT/EXT     D6      PB4
-// GM0          PA5     PB4
-// GM1          PA6     PB5
-// GM2          PA7     PB6
-//
-// Due to the interaction between the SAM and the VDG on the Dragon, there are 3
-// extra semigraphics modes, SG8, SG12 and SG24, that split the character space up
-// into 8, 12 and 24 pixels. These pixels are still half a character width but are
-// 3, 2 and 1 scanlines high respectively.
-// This happens by programming the VDG in text mode and the SAM in graphics mode.
-// The memory used for these modes is incresed so that each vertical part of the
-// character space is 32 bytes apart in memory.
-// For example in the SG8 mode, the top 2 pixels are encoded in the first byte
-// the next 2 in the second byte and so on.
-// In this way the bytes per character line are 128, 192, and 384.
-//
-// Mode     Bytes/line  Bytes/chars colours resolution  memory
-// SG4      32          1           8       64x32       512
-// SG6      32          1           4       64x48       512
-// SG8      128         4           8       64x64       2048
-// SG12     192         6           8       64x96       3072
-// SG24     384         12          8       64x192      6144
-//
-// In SG8, SG12, SG24, the byte format is the same as the byte format for SG4
-// However if ralative_line_no is < 6 pixels 2 and 3 are plotted. If it is > 6
-// pixels 0 and 1 are plotted.
-//
-
-// Changed parameter memory to be called vdu_base to avoid clash with global memory -- PHS
-uint16_t *do_text(scanvideo_scanline_buffer_t *buffer, uint relative_line_num, size_t vdu_base, uint16_t *p, bool is_debug)
+// The bits of each pixel of a byte that are the key colour, for BLIT_KEY
+static inline uint8_t blit_key_mask(uint8_t src, uint8_t key, uint pixel_size)
 {
-    // Screen is 16 rows x 32 columns
-    // Each char is 12 x 8 pixels
-    // Note we divide ralative_line_number by 2 as we are double scanning each 6847 line to
-    // 2 VGA lines.
-    uint row = (relative_line_num / 2) / 12;              // char row
-    uint sub_row = (relative_line_num / 2) % 12;          // scanline within current char row
-    uint sgidx = is_debug ? TEXT_INDEX : GetSAMSG();      // index into semigraphics table
-    uint rows_per_char = 12 / sg_bytes_row[sgidx];        // bytes per character space vertically
-    uint8_t *fontdata = fonts[fontno].fontdata + sub_row; // Local fontdata pointer
+    if (pixel_size == BLIT_KEY_1BPP)
+    {
+        return ~(src ^ ((key & 1) ? 0xFF : 0x00));
+    }
+    if (pixel_size == BLIT_KEY_2BPP)
+    {
+        uint8_t diff = src ^ ((key & 3) * 0x55);
+        diff = (diff | (diff >> 1)) & 0x55;
+        return ~(diff * 3);
+    }
+    return (src == key) ? 0xFF : 0x00;
+}
 
-    if (row < 16)
+static inline uint8_t blit_byte(uint op, uint8_t src, uint8_t dst, uint8_t value, uint pixel_size)
+{
+    switch (op)
     {
-        // Calc start address for this row
-        uint vdu_address = ((chars_per_row * sg_bytes_row[sgidx]) * row) + (chars_per_row * (sub_row / rows_per_char));
+    case BLIT_FILL:
+        return value;
+    case BLIT_OR:
+        return dst | src;
+    case BLIT_AND:
+        return dst & src;
+    case BLIT_XOR:
+        return dst ^ src;
+    case BLIT_KEY:
+    {
+        uint8_t keep = blit_key_mask(src, value, pixel_size);
+        return (dst & keep) | (src & ~keep);
+    }
+    default:
+        return src;
+    }
+}
 
-        for (int col = 0; col < 32; col++)
+void blit_run()
+{
+    uint16_t src = eb_get(BLIT_SRC) | (eb_get(BLIT_SRC + 1) << 8);
+    uint16_t dst = eb_get(BLIT_DST) | (eb_get(BLIT_DST + 1) << 8);
+    uint width = eb_get(BLIT_WIDTH);
+    uint height = eb_get(BLIT_HEIGHT);
+    uint src_stride = eb_get(BLIT_SRC_STRIDE);
+    uint dst_stride = eb_get(BLIT_DST_STRIDE);
+    uint op = eb_get(BLIT_OP) & BLIT_OP_MASK;
+    uint pixel_size = eb_get(BLIT_OP) & BLIT_KEY_MASK;
+    uint8_t value = eb_get(BLIT_VALUE);
+
+    // Work backwards when the destination is after the source, so an overlapping copy
+    // reads each byte before it is overwritten
+    bool backwards = (op != BLIT_FILL) && (dst > src);
+    for (uint r = 0; r < height; r++)
+    {
+        uint row = backwards ? height - 1 - r : r;
+        for (uint c = 0; c < width; c++)
         {
-            // Get character data from RAM and extract inv,ag,int/ext
-            // uint ch = vdu_base[vdu_address + col];
-            uint ch = eb_get(vdu_base + vdu_address + col);
-            bool inv = (ch & INV_MASK) ? true : false;
-            bool as = (ch & AS_MASK) ? true : false;
-            bool intext = GetIntExt(ch);
+            uint col = backwards ? width - 1 - c : c;
+            uint16_t s = src + row * src_stride + col;
+            uint16_t d = dst + row * dst_stride + col;
+            if (in_video_memory(d) && (op == BLIT_FILL || in_video_memory(s)))
+            {
+                eb_set(d, blit_byte(op, eb_get(s), eb_get(d), value, pixel_size));
+            }
+        }
+    }
+    eb_set(BLIT_STATUS, 0);
+}
 
-            uint16_t fg_colour;
-            uint16_t bg_colour = paper;
+// Extended video memory, see EXT_WINDOW. It is interleaved like _eb_memory so that the
+// renderers can read it in the same way.
+// The bitmap mode's memory and the sprite patterns are reached through the same window
+// and aren't interleaved. Banks of memory that isn't built in read as they were last
+// written and writes to them are dropped.
+#define EXT_BANKS (EXT_VRAM_SIZE / EXT_WINDOW_SIZE)
+#define BITMAP_BANKS (BITMAP_SIZE / EXT_WINDOW_SIZE)
+#define SPRITE_BANKS (SPRITE_PATTERN_SIZE / EXT_WINDOW_SIZE)
+#define SPRITE_BANK_FIRST (EXT_BANK_SPRITES & EXT_BANK_NUMBER)
+#if (EXT_BANKS > EXT_BANK_NUMBER + 1)
+#error EXT_VRAM_SIZE has more banks than EXT_BANK can select
+#endif
+#if (BITMAP_BANKS > SPRITE_BANK_FIRST)
+#error The bitmap banks run into EXT_BANK_SPRITES
+#endif
+#if (EXT_VRAM == 1)
+static uint8_t ext_vram[EXT_VRAM_SIZE * 2];
+#endif
+#if (BITMAP_MODE == 1)
+static uint32_t bitmap_fb[BITMAP_SIZE / 4];
+#endif
+static uint8_t sprite_patterns[SPRITE_PATTERN_SIZE];
 
-            // Deal with text mode first as we can decide this purely on the setting of the
-            // alpha/semi bit.
-            if (!as)
-            {
-                uint8_t b = fontdata[(ch & 0x3f) * 12];
+// The selected bank and the step from one of its bytes to the next
+static uint8_t *ext_bank_data = NULL;
+static uint ext_bank_step = 1;
 
-                fg_colour = alt_colour() ? ink_alt : ink;
+// The memory behind a bank, or NULL if it isn't built in
+static uint8_t *bank_data(uint bank, uint *step)
+{
+    uint number = bank & EXT_BANK_NUMBER;
+    *step = 1;
+    if (!(bank & EXT_BANK_BITMAP))
+    {
+#if (EXT_VRAM == 1)
+        *step = 2;
+        return &ext_vram[number % EXT_BANKS * EXT_WINDOW_SIZE * 2];
+#else
+        return NULL;
+#endif
+    }
+    if (number >= SPRITE_BANK_FIRST)
+    {
+        return &sprite_patterns[(number - SPRITE_BANK_FIRST) % SPRITE_BANKS * EXT_WINDOW_SIZE];
+    }
+#if (BITMAP_MODE == 1)
+    return &((uint8_t *)bitmap_fb)[number % BITMAP_BANKS * EXT_WINDOW_SIZE];
+#else
+    return NULL;
+#endif
+}
 
-                if (support_lower && ch >= LOWER_START && ch <= max_lower)
-                {
-                    b = fontdata[((ch & 0x3f) + 64) * 12];
+// Called by the bus event handler for a write to the window. The bank is the one
+// selected when the write was queued, as the events are handled in order.
+void ext_write(uint16_t address)
+{
+    if (ext_bank_data)
+    {
+        ext_bank_data[(address - EXT_WINDOW) * ext_bank_step] = eb_get(address);
+    }
+}
 
-                    if (LOWER_INVERT)
-                    {
-                        bg_colour = fg_colour;
-                        fg_colour = paper;
-                    }
-                }
-                else if (inv)
-                {
-                    bg_colour = fg_colour;
-                    fg_colour = paper;
-                }
+// Called by the bus event handler for a write to EXT_BANK, fills the window from the
+// bank for the 6502 to read then sets EXT_BANK_READY. The 6502 doesn't touch the window
+// until then, so the fill can't overwrite its writes. A second write to EXT_BANK before
+// the first is handled is served by the first, the register is only read here.
+void ext_select()
+{
+    uint bank = eb_get(EXT_BANK);
+    if (bank & EXT_BANK_READY)
+    {
+        return;
+    }
+    ext_bank_data = bank_data(bank, &ext_bank_step);
+    if (ext_bank_data)
+    {
+        for (uint i = 0; i < EXT_WINDOW_SIZE; i++)
+        {
+            eb_set(EXT_WINDOW + i, ext_bank_data[i * ext_bank_step]);
+        }
+    }
+    eb_set(EXT_BANK, bank | EXT_BANK_READY);
+}
 
-                if (b == 0)
-                {
-                    *p++ = COMPOSABLE_COLOR_RUN;
-                    *p++ = bg_colour;
-                    *p++ = 16 - 3;
-                }
-                else
-                {
-                    // The internal character generator is only 6 bits wide, however external
-                    // character ROMS are 8 bits wide so we must handle them here
-                    uint16_t c = (b & 0x80) ? fg_colour : bg_colour;
-                    *p++ = COMPOSABLE_RAW_RUN;
-                    *p++ = c;
-                    *p++ = 16 - 3;
-                    *p++ = c;
-                    for (uint8_t mask = 0x40; mask > 0; mask = mask >> 1)
-                    {
-                        c = (b & mask) ? fg_colour : bg_colour;
-                        *p++ = c;
-                        *p++ = c;
-                    }
-                }
-            }
-            else // Semigraphics
-            {
-                uint colour_index;
+// Drawing engine, see DRAW_BASE. The 6502 queues the command bytes in DRAW_RING, the
+// bus event handler picks up DRAW_HEAD and core0 draws them in its main loop. Only the
+// head moves with a bus event, so events that batch up can't lose any bytes.
 
-                if (as && intext)
-                {
-                    sgidx = SG6_INDEX; // SG6
-                }
+static volatile uint8_t draw_in = 0;  // DRAW_HEAD when it was last handled
+static volatile uint8_t draw_out = 0; // next byte to draw, as in DRAW_TAIL
+static volatile bool draw_restart = false;
+static volatile uint8_t draw_restart_at = 0;
 
-                colour_index = (SG6_INDEX == sgidx) ? (ch & SG6_COL_MASK) >> SG6_COL_SHIFT : (ch & SG4_COL_MASK) >> SG4_COL_SHIFT;
+// Called by the bus event handler for a write to the drawing registers
+void draw_write(uint16_t address)
+{
+    uint8_t head = eb_get(DRAW_HEAD) % DRAW_RING_LEN;
+    if (address == DRAW_STATUS)
+    {
+        // Everything queued so far is dropped by draw_run()
+        draw_restart_at = head;
+        draw_restart = true;
+        draw_in = head;
+        eb_set(DRAW_STATUS, DRAW_BUSY);
+        return;
+    }
+    uint added = (head - draw_in + DRAW_RING_LEN) % DRAW_RING_LEN;
+    uint space = (draw_out - draw_in - 1 + DRAW_RING_LEN) % DRAW_RING_LEN;
+    if (added > space)
+    {
+        // The head passed the tail, so bytes that weren't drawn have been overwritten
+        draw_restart_at = head;
+        draw_restart = true;
+        draw_in = head;
+        eb_set(DRAW_STATUS, eb_get(DRAW_STATUS) | DRAW_OVERFLOW | DRAW_BUSY);
+        return;
+    }
+    draw_in = head;
+    if (added)
+    {
+        eb_set(DRAW_STATUS, eb_get(DRAW_STATUS) | DRAW_BUSY);
+    }
+}
 
-                if (alt_colour() && (SG6_INDEX == sgidx))
-                {
-                    colour_index += 4;
-                }
+bool draw_pending()
+{
+    return draw_in != draw_out || draw_restart;
+}
 
-                fg_colour = colour_palette_atom[colour_index];
+// Geometry of the graphics mode being drawn into, set for each command
+static struct
+{
+    int width;
+    int height;
+    uint row_bytes;
+    bool two_bpp;
+    uint16_t base;
+} draw_screen;
 
-                uint pix_row = (SG6_INDEX == sgidx) ? 2 - (sub_row / 4) : 1 - (sub_row / 6);
+static uint8_t draw_colour = 1;
+static uint8_t draw_page = 0;
 
-                uint16_t pix0 = ((ch >> (pix_row * 2)) & 0x1) ? fg_colour : bg_colour;
-                uint16_t pix1 = ((ch >> (pix_row * 2)) & 0x2) ? fg_colour : bg_colour;
-                *p++ = COMPOSABLE_COLOR_RUN;
-                *p++ = pix1;
-                *p++ = 8 - 3;
-                *p++ = COMPOSABLE_COLOR_RUN;
-                *p++ = pix0;
-                *p++ = 8 - 3;
-            }
-        }
+static inline bool draw_address(int x, int y, uint16_t *address, uint *shift)
+{
+    if (x < 0 || y < 0 || x >= draw_screen.width || y >= draw_screen.height)
+    {
+        return false;
     }
-    return p;
+    if (draw_screen.two_bpp)
+    {
+        *address = draw_screen.base + y * draw_screen.row_bytes + x / 4;
+        *shift = (3 - (x & 3)) * 2;
+    }
+    else
+    {
+        *address = draw_screen.base + y * draw_screen.row_bytes + x / 8;
+        *shift = 7 - (x & 7);
+    }
+    return in_video_memory(*address);
 }
 
-void draw_color_bar(scanvideo_scanline_buffer_t *buffer)
+// The colour of a pixel, or -1 if it is off the screen
+static int get_pixel(int x, int y)
 {
-    const uint mode = get_mode();
-    const uint line_num = scanvideo_scanline_number(buffer->scanline_id);
-    uint16_t *p = (uint16_t *)buffer->data;
-    int relative_line_num = line_num - vertical_offset;
-    uint16_t *art_palette = (1 == artifact) ? colour_palette_artifact1 : colour_palette_artifact2;
-
-    if (line_num == 0)
+    uint16_t address;
+    uint shift;
+    if (!draw_address(x, y, &address, &shift))
     {
-        check_command();
-        update_debug_text();
-        check_reset();
+        return -1;
     }
+    return (eb_get(address) >> shift) & (draw_screen.two_bpp ? 3 : 1);
+}
 
-    uint16_t *palette = colour_palette;
-    if (alt_colour())
+static void plot(int x, int y)
+{
+    uint16_t address;
+    uint shift;
+    if (draw_address(x, y, &address, &shift))
     {
-        palette += 4;
+        uint mask = (draw_screen.two_bpp ? 3 : 1) << shift;
+        eb_set(address, (eb_get(address) & ~mask) | ((draw_colour << shift) & mask));
     }
+}
 
-    // Graphics modes have a coloured border, text modes have a black border
-    uint16_t border_colour = (mode & 1) ? palette[0] : 0;
-    uint debug_end = debug ? debug_start + 24 : debug_start;
-
-    if (relative_line_num < 0 || line_num >= debug_end)
+static void draw_hline(int x0, int x1, int y)
+{
+    if (x0 > x1)
     {
-        // Add top/bottom borders
-        p = add_border(p, border_colour, vga_width);
+        int t = x0;
+        x0 = x1;
+        x1 = t;
     }
-    else
+    x0 = MAX(x0, 0);
+    x1 = MIN(x1, draw_screen.width - 1);
+    for (int x = x0; x <= x1; x++)
     {
+        plot(x, y);
+    }
+}
 
-        // Add left border
-        p = add_border(p, border_colour, horizontal_offset - 1);
-
-        if (line_num >= debug_start && line_num < debug_end) // Debug in 'text' mode
+// Bresenham's line
+static void draw_line(int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx + dy;
+    for (;;)
+    {
+        plot(x0, y0);
+        if (x0 == x1 && y0 == y1)
         {
-            // p = do_text(buffer, line_num - debug_start, debug_text, p, true);
+            break;
         }
-        else if (!(mode & 1)) // Alphanumeric or Semigraphics
+        int e2 = 2 * err;
+        if (e2 >= dy)
         {
-            if (relative_line_num >= 0 && relative_line_num < (16 * 24))
-            {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Midpoint circle, an outline or filled with a line across each pair of octants
+static void draw_circle(int cx, int cy, int r, bool fill)
+{
+    int x = r;
+    int y = 0;
+    int err = 1 - r;
+    while (x >= y)
+    {
+        if (fill)
+        {
+            draw_hline(cx - x, cx + x, cy + y);
+            draw_hline(cx - x, cx + x, cy - y);
+            draw_hline(cx - y, cx + y, cy + x);
+            draw_hline(cx - y, cx + y, cy - x);
+        }
+        else
+        {
+            plot(cx + x, cy + y);
+            plot(cx - x, cy + y);
+            plot(cx + x, cy - y);
+            plot(cx - x, cy - y);
+            plot(cx + y, cy + x);
+            plot(cx - y, cy + x);
+            plot(cx + y, cy - x);
+            plot(cx - y, cy - x);
+        }
+        y++;
+        if (err < 0)
+        {
+            err += 2 * y + 1;
+        }
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// Even-odd scanline fill through the centre of each row, then the edges so that the
+// shape covers the same pixels as its outline
+static void draw_polygon(const uint8_t *points, uint count)
+{
+    int top = points[1];
+    int bottom = points[1];
+    for (uint i = 1; i < count; i++)
+    {
+        top = MIN(top, points[i * 2 + 1]);
+        bottom = MAX(bottom, points[i * 2 + 1]);
+    }
+    bottom = MIN(bottom, draw_screen.height - 1);
+    for (int y = top; y <= bottom; y++)
+    {
+        int xs[DRAW_MAX_POINTS];
+        uint crossings = 0;
+        for (uint i = 0; i < count; i++)
+        {
+            int x0 = points[i * 2];
+            int y0 = points[i * 2 + 1];
+            int x1 = points[(i + 1) % count * 2];
+            int y1 = points[(i + 1) % count * 2 + 1];
+            if ((y0 <= y) != (y1 <= y))
+            {
+                // Crossing at y + 0.5, rounded to the nearest pixel
+                int num = (2 * y + 1 - 2 * y0) * (x1 - x0);
+                int den = 2 * (y1 - y0);
+                if (den < 0)
+                {
+                    num = -num;
+                    den = -den;
+                }
+                int q = 2 * num + den;
+                int x = x0 + ((q >= 0) ? q / (2 * den) : -((2 * den - 1 - q) / (2 * den)));
+                uint j = crossings++;
+                while (j > 0 && xs[j - 1] > x)
+                {
+                    xs[j] = xs[j - 1];
+                    j--;
+                }
+                xs[j] = x;
+            }
+        }
+        for (uint i = 0; i + 1 < crossings; i += 2)
+        {
+            draw_hline(xs[i], xs[i + 1], y);
+        }
+    }
+    for (uint i = 0; i < count; i++)
+    {
+        draw_line(points[i * 2], points[i * 2 + 1], points[(i + 1) % count * 2], points[(i + 1) % count * 2 + 1]);
+    }
+}
+
+// Scanline flood fill. Spans that don't fit on the stack are left unfilled, and
+// DRAW_UNFILLED tells the 6502.
+#define FLOOD_STACK_LEN 256
+static void draw_flood(int x, int y)
+{
+    int target = get_pixel(x, y);
+    if (target < 0 || target == (draw_colour & (draw_screen.two_bpp ? 3 : 1)))
+    {
+        return;
+    }
+    static uint8_t stack[FLOOD_STACK_LEN][2];
+    uint sp = 0;
+    bool dropped = false;
+    stack[sp][0] = x;
+    stack[sp][1] = y;
+    sp++;
+    while (sp > 0)
+    {
+        sp--;
+        x = stack[sp][0];
+        y = stack[sp][1];
+        if (get_pixel(x, y) != target)
+        {
+            continue;
+        }
+        int left = x;
+        int right = x;
+        while (get_pixel(left - 1, y) == target)
+        {
+            left--;
+        }
+        while (get_pixel(right + 1, y) == target)
+        {
+            right++;
+        }
+        draw_hline(left, right, y);
+        for (int ny = y - 1; ny <= y + 1; ny += 2)
+        {
+            bool in_run = false;
+            for (int nx = left; nx <= right; nx++)
+            {
+                bool match = (get_pixel(nx, ny) == target);
+                if (match && !in_run)
+                {
+                    if (sp < FLOOD_STACK_LEN)
+                    {
+                        stack[sp][0] = nx;
+                        stack[sp][1] = ny;
+                        sp++;
+                    }
+                    else
+                    {
+                        dropped = true;
+                    }
+                }
+                in_run = match;
+            }
+        }
+    }
+
+    // Tell the 6502 that spans were left unfilled, see DRAW_UNFILLED
+    if (dropped)
+    {
+        irq_set_enabled(DMA_IRQ_1, false);
+        eb_set(DRAW_STATUS, eb_get(DRAW_STATUS) | DRAW_UNFILLED);
+        irq_set_enabled(DMA_IRQ_1, true);
+    }
+}
+
+// Bytes in a command so far, including the command, or 0 if that's not yet known
+static uint draw_command_len(const uint8_t *cmd, uint len)
+{
+    static const uint8_t params[] = {
+        [DRAW_COLOUR] = 1,
+        [DRAW_PAGE] = 1,
+        [DRAW_CLEAR] = 0,
+        [DRAW_POINT] = 2,
+        [DRAW_LINE] = 4,
+        [DRAW_BOX] = 4,
+        [DRAW_RECT] = 4,
+        [DRAW_CIRCLE] = 3,
+        [DRAW_DISC] = 3,
+        [DRAW_TRIANGLE] = 6,
+        [DRAW_FLOOD] = 2,
+    };
+    if (cmd[0] == DRAW_POLYGON)
+    {
+        return (len < 2) ? 0 : 2 + MIN(MAX(cmd[1], 3), DRAW_MAX_POINTS) * 2;
+    }
+    return 1 + ((cmd[0] < count_of(params)) ? params[cmd[0]] : 0);
+}
+
+static void draw_command(const uint8_t *cmd)
+{
+    if (cmd[0] == DRAW_COLOUR)
+    {
+        draw_colour = cmd[1];
+        return;
+    }
+    if (cmd[0] == DRAW_PAGE)
+    {
+        draw_page = cmd[1];
+        return;
+    }
+
+    uint mode = get_mode();
+    if (!(mode & 1))
+    {
+        return;
+    }
+    draw_screen.width = get_width(mode);
+    draw_screen.height = get_height(mode);
+    draw_screen.row_bytes = bytes_per_row(mode);
+    draw_screen.two_bpp = is_colour(mode);
+    draw_screen.base = GetVidMemBase() + draw_page * 256;
+
+    const uint8_t *p = cmd + 1;
+    switch (cmd[0])
+    {
+    case DRAW_CLEAR:
+        for (int y = 0; y < draw_screen.height; y++)
+        {
+            draw_hline(0, draw_screen.width - 1, y);
+        }
+        break;
+    case DRAW_POINT:
+        plot(p[0], p[1]);
+        break;
+    case DRAW_LINE:
+        draw_line(p[0], p[1], p[2], p[3]);
+        break;
+    case DRAW_BOX:
+        draw_hline(p[0], p[2], p[1]);
+        draw_hline(p[0], p[2], p[3]);
+        draw_line(p[0], p[1], p[0], p[3]);
+        draw_line(p[2], p[1], p[2], p[3]);
+        break;
+    case DRAW_RECT:
+        for (int y = MIN(p[1], p[3]); y <= MAX(p[1], p[3]); y++)
+        {
+            draw_hline(p[0], p[2], y);
+        }
+        break;
+    case DRAW_CIRCLE:
+    case DRAW_DISC:
+        draw_circle(p[0], p[1], p[2], cmd[0] == DRAW_DISC);
+        break;
+    case DRAW_TRIANGLE:
+        draw_polygon(p, 3);
+        break;
+    case DRAW_POLYGON:
+        draw_polygon(p + 1, MIN(MAX(p[0], 3), DRAW_MAX_POINTS));
+        break;
+    case DRAW_FLOOD:
+        draw_flood(p[0], p[1]);
+        break;
+    }
+}
+
+// Draw the queued commands, called by core0's main loop
+void draw_run()
+{
+    static uint8_t cmd[2 + DRAW_MAX_POINTS * 2];
+    static uint len = 0;
+    for (;;)
+    {
+        if (draw_restart)
+        {
+            draw_restart = false;
+            draw_out = draw_restart_at;
+            eb_set(DRAW_TAIL, draw_out);
+            len = 0;
+        }
+        if (draw_out == draw_in)
+        {
+            break;
+        }
+        cmd[len++] = eb_get(DRAW_RING + draw_out);
+        draw_out = (draw_out + 1) % DRAW_RING_LEN;
+        eb_set(DRAW_TAIL, draw_out);
+        uint need = draw_command_len(cmd, len);
+        if (need && len >= need)
+        {
+            draw_command(cmd);
+            len = 0;
+        }
+    }
+
+    irq_set_enabled(DMA_IRQ_1, false);
+    if (draw_out == draw_in && !draw_restart)
+    {
+        eb_set(DRAW_STATUS, eb_get(DRAW_STATUS) & ~DRAW_BUSY);
+    }
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+const uint chars_per_row = 32;
+
+const uint vga_width = 640;
+const uint vga_height = 480;
+const uint line_us = 32; // one 640x480 scanline is 31.8us
+
+const uint max_width = 512;
+const uint max_height = 384;
+
+const uint vertical_offset = (vga_height - max_height) / 2;
+const uint horizontal_offset = (vga_width - max_width) / 2;
+
+const uint debug_start = max_height + vertical_offset;
+
+// The debug and performance overlay is drawn in the bottom border as single height text,
+// 12 lines a row, from its own buffer laid out like _eb_memory so do_text() can read it
+#define OSD_ROWS 3
+static uint8_t osd_vram[OSD_ROWS * 32 * 2];
+
+static void osd_row(uint row, const char *text)
+{
+    for (uint i = 0; i < debug_text_len; i++)
+    {
+        osd_vram[(row * 32 + i) * 2] = text[i];
+    }
+}
+
+// Fill the overlay buffer, returns the number of rows to show
+static uint latch_osd()
+{
+    uint rows = 0;
+    if (debug)
+    {
+        osd_row(rows++, debug_text);
+    }
+    if (perf)
+    {
+        osd_row(rows++, perf_text[0]);
+        osd_row(rows++, perf_text[1]);
+    }
+    return rows;
+}
+
+volatile render_load_t render_load[2];
+
+uint16_t *add_border(uint16_t *p, uint16_t border_colour, uint16_t len)
+{
+    *p++ = COMPOSABLE_COLOR_RUN;
+    *p++ = border_colour;
+    *p++ = len - 3;
+    return p;
+}
+
+// Minimum length in VGA pixels of a single colour run before it is emitted as a
+// COMPOSABLE_COLOR_RUN. A colour run token costs 3 halfwords, and so does reopening the
+// raw run that follows it, so anything shorter is cheaper left as raw pixels.
+#define RLE_MIN_RUN 8
+
+// Run length encoder for the graphics modes. Pixels are pushed one 6847 pixel at a time
+// and identical neighbours are coalesced, so a mostly blank line becomes a handful of
+// colour runs instead of a 512 pixel raw run.
+typedef struct
+{
+    uint16_t *p;     // next free halfword in the scanline buffer
+    uint16_t *raw;   // token of the open raw run, NULL if there isn't one
+    uint raw_len;    // pixels in the open raw run
+    uint16_t colour; // colour of the pending run
+    uint len;        // pixels in the pending run
+} rle_t;
+
+static inline void rle_begin(rle_t *rle, uint16_t *p, uint16_t colour, uint len)
+{
+    rle->p = p;
+    rle->raw = NULL;
+    rle->raw_len = 0;
+    rle->colour = colour;
+    rle->len = len;
+}
+
+// Terminate the open raw run, using the short forms where the run is too short for a
+// COMPOSABLE_RAW_RUN
+static inline void rle_close_raw(rle_t *rle)
+{
+    uint16_t *raw = rle->raw;
+    if (raw)
+    {
+        if (rle->raw_len == 1)
+        {
+            raw[0] = COMPOSABLE_RAW_1P;
+            rle->p = raw + 2;
+        }
+        else if (rle->raw_len == 2)
+        {
+            raw[0] = COMPOSABLE_RAW_2P;
+            raw[2] = raw[3];
+            rle->p = raw + 3;
+        }
+        else
+        {
+            raw[2] = rle->raw_len - 3;
+        }
+        rle->raw = NULL;
+    }
+}
+
+static inline void rle_flush(rle_t *rle)
+{
+    uint16_t *p = rle->p;
+    uint len = rle->len;
+    if (len >= RLE_MIN_RUN)
+    {
+        rle_close_raw(rle);
+        p = rle->p;
+        *p++ = COMPOSABLE_COLOR_RUN;
+        *p++ = rle->colour;
+        *p++ = len - 3;
+    }
+    else if (len > 0)
+    {
+        if (!rle->raw)
+        {
+            // Raw run layout is token, first pixel, count - 3, remaining pixels
+            rle->raw = p;
+            rle->raw_len = 0;
+            *p++ = COMPOSABLE_RAW_RUN;
+            *p++ = rle->colour;
+            p++;
+            rle->raw_len++;
+            len--;
+        }
+        rle->raw_len += len;
+        while (len--)
+        {
+            *p++ = rle->colour;
+        }
+    }
+    rle->p = p;
+    rle->len = 0;
+}
+
+static inline void rle_push(rle_t *rle, uint16_t colour, uint len)
+{
+    if (colour != rle->colour)
+    {
+        rle_flush(rle);
+        rle->colour = colour;
+    }
+    rle->len += len;
+}
+
+static inline uint16_t *rle_end(rle_t *rle)
+{
+    rle_flush(rle);
+    rle_close_raw(rle);
+    return rle->p;
+}
+
+// Highest number of 32-bit words used by any scanline so far, sizes
+// PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS
+volatile uint16_t scanline_words_max = 0;
+
+// Terminate the scanline and hand it back to scanvideo
+static void end_scanline(scanvideo_scanline_buffer_t *buffer, uint16_t *p)
+{
+    // black pixel to end line
+    *p++ = COMPOSABLE_RAW_1P;
+    *p++ = 0;
+    // end of line with alignment padding
+    if (!(3u & (uintptr_t)p))
+    {
+        *p++ = COMPOSABLE_EOL_SKIP_ALIGN;
+    }
+    else
+    {
+        *p++ = COMPOSABLE_EOL_ALIGN;
+    }
+    *p++ = 0;
+
+    buffer->data_used = ((uint32_t *)p) - buffer->data;
+    assert(buffer->data_used < buffer->data_max);
+
+    if (buffer->data_used > scanline_words_max)
+    {
+        scanline_words_max = buffer->data_used;
+    }
+
+    buffer->status = SCANLINE_OK;
+}
+
+// Video memory is read through a pointer to the first byte of the frame buffer, either
+// in _eb_memory or in the frame snapshot, which both interleave the data with the
+// permission bytes.
+
+/// @brief get a byte of video memory
+/// @param vram start of the frame buffer
+/// @param offset offset from the start of the frame buffer
+/// @return the value of the byte
+static inline uint8_t vram_get(const volatile uint8_t *vram, uint offset)
+{
+    return vram[offset * 2];
+}
+
+/// @brief get 4 bytes of video memory as a big endian 32 bit value
+/// @param vram start of the frame buffer
+/// @param offset offset from the start of the frame buffer
+/// @return the 32 bit value
+static inline uint32_t vram_get32(const volatile uint8_t *vram, uint offset)
+{
+    vram += offset * 2;
+    return (vram[0] << 24) + (vram[2] << 16) + (vram[4] << 8) + vram[6];
+}
+
+// The graphics modes can be expanded from a lookup table of ready made VGA pixels, built
+// for the mode and palette. Each nibble of video memory (four 1bpp or two 2bpp pixels)
+// indexes GRAPHICS_LUT_STRIDE words of pixel pairs, of which only the first
+// 128 / bytes_per_row() are used, and the line is copied out a word at a time.
+#define GRAPHICS_LUT_STRIDE 16
+#define GRAPHICS_LUT_WORDS (16 * GRAPHICS_LUT_STRIDE)
+
+static uint32_t graphics_lut[2][GRAPHICS_LUT_WORDS];
+
+// The mode and colour set each frame parity's table was built for, UINT32_MAX when
+// latch_palette() has changed one of its colours, and the nibbles that are one colour
+static uint graphics_lut_built[2] = {UINT32_MAX, UINT32_MAX};
+static uint16_t graphics_lut_uniform[2];
+
+// Build the lookup table for the latched graphics mode, if there is one and the table
+// isn't already built for it. Call after latch_palette().
+static void latch_graphics_lut(render_state_t *rs, uint parity)
+{
+    rs->graphics_lut = NULL;
+    if ((GRAPHICS_LUT == 0) || !(rs->mode & 1) || is_artifact(rs->mode, rs->artifact))
+    {
+        return;
+    }
+
+    const uint mode = rs->mode;
+    uint32_t *lut = graphics_lut[parity];
+    rs->graphics_lut = lut;
+    rs->lut_mode = mode;
+    rs->lut_css = rs->css;
+    if (graphics_lut_built[parity] == (mode | (rs->css << 4)))
+    {
+        rs->lut_uniform = graphics_lut_uniform[parity];
+        return;
+    }
+
+    const uint16_t *palette = rs->css ? rs->colours + 4 : rs->colours;
+    const bool two_bpp = is_colour(mode);
+    const uint words = 128 / bytes_per_row(mode);
+    const uint pixels = two_bpp ? 2 : 4;
+    const uint width = words * 2 / pixels; // VGA pixels per 6847 pixel
+
+    for (uint nibble = 0; nibble < 16; nibble++)
+    {
+        uint16_t *q = (uint16_t *)&lut[nibble * GRAPHICS_LUT_STRIDE];
+        for (uint pixel = 0; pixel < pixels; pixel++)
+        {
+            uint16_t colour;
+            if (two_bpp)
+            {
+                colour = palette[(nibble >> (2 - pixel * 2)) & 3];
+            }
+            else
+            {
+                colour = (nibble & (8 >> pixel)) ? palette[0] : 0;
+            }
+            for (uint i = 0; i < width; i++)
+            {
+                *q++ = colour;
+            }
+        }
+    }
+
+    // Nibbles that expand to a single colour, which graphics_from_lut() coalesces
+    uint16_t uniform = 0;
+    for (uint nibble = 0; nibble < 16; nibble++)
+    {
+        const uint16_t *q = (const uint16_t *)&lut[nibble * GRAPHICS_LUT_STRIDE];
+        uint i = 1;
+        while (i < words * 2 && q[i] == q[0])
+        {
+            i++;
+        }
+        if (i == words * 2)
+        {
+            uniform |= 1 << nibble;
+        }
+    }
+
+    graphics_lut_built[parity] = mode | (rs->css << 4);
+    graphics_lut_uniform[parity] = uniform;
+    rs->lut_uniform = uniform;
+}
+
+// Write one graphics line from the lookup table, with the extra border pixel first. The
+// layout of the borders puts the pixels on a word boundary.
+//
+// Runs of identical bytes that are all one colour become colour runs, like the run length
+// encoder does, so a mostly blank line doesn't fill the scanline buffer. Each colour run
+// ends one pixel short and the next raw run starts with that pixel, so the token and
+// header between them are six halfwords and the raw pixels stay word aligned.
+static uint16_t *graphics_from_lut(const render_state_t *rs, uint16_t *p, uint16_t border_colour, size_t bp)
+{
+    const uint bytes = bytes_per_row(rs->mode);
+    const uint words = 128 / bytes;
+
+    // Raw run layout is token, first pixel, count - 3, remaining pixels
+    uint16_t *raw = p;
+    uint raw_len = 1;
+    *p++ = COMPOSABLE_RAW_RUN;
+    *p++ = border_colour;
+    p++;
+
+    uint i = 0;
+    while (i < bytes)
+    {
+        uint8_t b = vram_get(rs->vram, bp + i);
+        uint nibble = b & 15;
+        if ((b >> 4) == nibble && (rs->lut_uniform & (1 << nibble)))
+        {
+            uint end = i + 1;
+            while (end < bytes && vram_get(rs->vram, bp + end) == b)
+            {
+                end++;
+            }
+            uint16_t colour = rs->graphics_lut[nibble * GRAPHICS_LUT_STRIDE];
+            uint len = (end - i) * words * 4;
+            if (raw_len == 1)
+            {
+                // The raw run is only its first pixel, so it takes one of the run and
+                // becomes a two pixel token of the same size
+                raw[0] = COMPOSABLE_RAW_2P;
+                raw[2] = colour;
+                len--;
+            }
+            else
+            {
+                raw[2] = raw_len - 3;
+            }
+            bool more = end < bytes;
+            *p++ = COMPOSABLE_COLOR_RUN;
+            *p++ = colour;
+            *p++ = len - more - 3;
+            if (more)
+            {
+                raw = p;
+                raw_len = 1;
+                *p++ = COMPOSABLE_RAW_RUN;
+                *p++ = colour;
+                p++;
+            }
+            else
+            {
+                raw = NULL;
+            }
+            i = end;
+            continue;
+        }
+
+        const uint32_t *hi = &rs->graphics_lut[(b >> 4) * GRAPHICS_LUT_STRIDE];
+        const uint32_t *lo = &rs->graphics_lut[nibble * GRAPHICS_LUT_STRIDE];
+        uint32_t *q = (uint32_t *)p;
+        for (uint w = 0; w < words; w++)
+        {
+            *q++ = hi[w];
+        }
+        for (uint w = 0; w < words; w++)
+        {
+            *q++ = lo[w];
+        }
+        p = (uint16_t *)q;
+        raw_len += words * 4;
+        i++;
+    }
+    if (raw)
+    {
+        raw[2] = raw_len - 3;
+    }
+    return p;
+}
+
+// NTSC artifact colours depend on the neighbouring pixels as well as the pixel itself.
+// Each 256 wide pixel is two VGA pixels and its colour is decoded from a window of three
+// pixels and its phase, even pixels are the first of a pair:
+//
+//   off, both neighbours off    black
+//   on, both neighbours on      white
+//   on, neighbours off          the colour of a lone pixel of this phase
+//   off, both neighbours on     the colour of a lone pixel of the other phase
+//   on, one neighbour on        half way between the lone pixel colour and white
+//   off, one neighbour on       half way between the neighbour's colour and black
+//
+// A pair of pixels with a pixel either side is a four bit window, which indexes a table
+// of two pixel-pair words for each artifact palette. There are tables for each frame
+// parity, rebuilt by latch_palette() when one of their colours changes.
+static uint32_t artifact_lut[2][2][16][2];
+
+// Average two colours a channel at a time, rounding up
+static uint16_t blend_colour(uint16_t a, uint16_t b)
+{
+    uint16_t colour = 0;
+    for (uint shift = 10; shift < 16; shift += 2)
+    {
+        uint channel = (((a >> shift) & 3) + ((b >> shift) & 3) + 1) >> 1;
+        colour |= channel << shift;
+    }
+    return colour;
+}
+
+static uint16_t artifact_pixel(const uint16_t *palette, uint left, uint pixel, uint right, uint odd)
+{
+    // Lone pixels are 01 or 10 in the old pair palette
+    uint16_t own = palette[odd ? 1 : 2];
+    uint16_t other = palette[odd ? 2 : 1];
+    if (pixel)
+    {
+        if (left && right)
+        {
+            return palette[3];
+        }
+        return (left || right) ? blend_colour(own, palette[3]) : own;
+    }
+    if (left && right)
+    {
+        return other;
+    }
+    return (left || right) ? blend_colour(other, palette[0]) : palette[0];
+}
+
+static void build_artifact_lut(uint32_t (*lut)[16][2], const uint16_t *colours)
+{
+    for (uint art = 0; art < 2; art++)
+    {
+        uint16_t palette[4];
+        for (uint i = 0; i < 4; i++)
+        {
+            palette[i] = colours[artifact_colours[art][i]];
+        }
+        for (uint window = 0; window < 16; window++)
+        {
+            uint left = (window >> 3) & 1;
+            uint even = (window >> 2) & 1;
+            uint odd = (window >> 1) & 1;
+            uint right = window & 1;
+            uint32_t c0 = artifact_pixel(palette, left, even, odd, 0);
+            uint32_t c1 = artifact_pixel(palette, even, odd, right, 1);
+            lut[art][window][0] = c0 | (c0 << 16);
+            lut[art][window][1] = c1 | (c1 << 16);
+        }
+    }
+}
+
+// Write one artifacted line as a single raw run with the extra border pixel first, like graphics_from_lut()
+static uint16_t *artifact_line(const render_state_t *rs, uint16_t *p, uint16_t border_colour, size_t bp)
+{
+    const uint32_t(*lut)[2] = rs->artifact_lut[rs->artifact - 1];
+    const uint bytes = bytes_per_row(rs->mode);
+
+    *p++ = COMPOSABLE_RAW_RUN;
+    *p++ = border_colour;
+    *p++ = max_width + 1 - 3;
+
+    uint32_t *q = (uint32_t *)p;
+    // The pixels either side of the line are off
+    uint prev = 0;
+    uint b = vram_get(rs->vram, bp);
+    for (uint i = 0; i < bytes; i++)
+    {
+        uint next = (i + 1 < bytes) ? vram_get(rs->vram, bp + i + 1) : 0;
+        // Ten bits of pixels, the last pixel of the previous byte, this byte and the
+        // first pixel of the next
+        uint bits = (prev << 9) | (b << 1) | (next >> 7);
+        for (int shift = 6; shift >= 0; shift -= 2)
+        {
+            const uint32_t *pair = lut[(bits >> shift) & 15];
+            *q++ = pair[0];
+            *q++ = pair[1];
+        }
+        prev = b & 1;
+        b = next;
+    }
+    return (uint16_t *)q;
+}
+
+#if (BITMAP_MODE == 1)
+// The bitmap mode expands a byte of two 16 colour pixels to two words of pixel pairs
+static uint32_t bitmap_lut[2][256][2];
+#endif
+
+// The palette registers as they are in each frame parity's lookup tables. The tables are
+// brought up to date when a frame is latched, only where they use an entry that has
+// changed.
+static uint8_t palette_shown[2][PALETTE_ENTRIES];
+
+// colour_palette_atom as each frame parity's palette shows it, see vdg_palette_entry
+static uint16_t vdg_colours[2][NO_COLOURS];
+
+static inline uint32_t palette_pair(uint8_t value)
+{
+    return (value << 8) | (value << 24);
+}
+
+// The 80 column LUT allows two pixels to be calculated at once, taking account of the
+// attribute byte for colours
+//
+// Bit  8  7  6  5  4  3  2  1   0
+//      --bgc--  x  --fgc--  p1 p0
+//
+static inline uint32_t vga80_lut_entry(const uint8_t *palette, uint i)
+{
+    uint16_t fg = palette[(i >> 2) & 7] << 8;
+    uint16_t bg = palette[(i >> 6) & 7] << 8;
+    return (((i & 1) ? fg : bg) << 16) | ((i & 2) ? fg : bg);
+}
+
+static void reset_palette()
+{
+    for (uint i = 0; i < PALETTE_ENTRIES; i++)
+    {
+        eb_set(PALETTE_BASE + i, colour_palette_default[i] >> 8);
+    }
+}
+
+void initialize_palette()
+{
+    reset_palette();
+    for (uint parity = 0; parity < 2; parity++)
+    {
+        uint8_t *shown = palette_shown[parity];
+        for (uint i = 0; i < PALETTE_ENTRIES; i++)
+        {
+            shown[i] = eb_get(PALETTE_BASE + i);
+        }
+        for (uint i = 0; i < NO_COLOURS; i++)
+        {
+            vdg_colours[parity][i] = shown[vdg_palette_entry[i]] << 8;
+        }
+        build_artifact_lut(artifact_lut[parity], vdg_colours[parity]);
+        for (uint i = 0; i < 128 * 4; i++)
+        {
+            vga80_lut[parity][i] = vga80_lut_entry(shown, i);
+        }
+#if (BITMAP_MODE == 1)
+        for (uint b = 0; b < 256; b++)
+        {
+            bitmap_lut[parity][b][0] = palette_pair(shown[b >> 4]);
+            bitmap_lut[parity][b][1] = palette_pair(shown[b & 15]);
+        }
+#endif
+    }
+}
+
+// The colour that ink, paper or ink_alt show as, they hold one of colour_palette_atom
+static uint16_t preset_colour(const uint16_t *colours, uint16_t colour)
+{
+    for (uint i = 0; i < NO_COLOURS; i++)
+    {
+        if (colour_palette_atom[i] == colour)
+        {
+            return colours[i];
+        }
+    }
+    return colour;
+}
+
+// Bring a frame parity's lookup tables up to date with the palette registers. Call after
+// latch_render_state(), as the text colours are mapped through the palette.
+static void latch_palette(render_state_t *rs, uint parity)
+{
+    uint8_t *shown = palette_shown[parity];
+    uint32_t *vga80 = vga80_lut[parity];
+#if (BITMAP_MODE == 1)
+    uint32_t(*bitmap)[2] = bitmap_lut[parity];
+#endif
+    uint16_t *colours = vdg_colours[parity];
+    bool artifact_changed = false;
+    for (uint c = 0; c < PALETTE_ENTRIES; c++)
+    {
+        uint8_t value = eb_get(PALETTE_BASE + c);
+        if (value == shown[c])
+        {
+            continue;
+        }
+        shown[c] = value;
+
+        // The 6847 colours shown by the entry
+        for (uint i = 0; i < NO_COLOURS; i++)
+        {
+            if (vdg_palette_entry[i] == c)
+            {
+                colours[i] = shown[c] << 8;
+                graphics_lut_built[parity] = UINT32_MAX;
+                for (uint art = 0; art < 2; art++)
+                {
+                    for (uint j = 0; j < 4; j++)
+                    {
+                        artifact_changed |= (artifact_colours[art][j] == i);
+                    }
+                }
+            }
+        }
+
+#if (BITMAP_MODE == 1)
+        // Bitmap bytes with the colour in either pixel
+        uint32_t pair = palette_pair(shown[c]);
+        for (uint other = 0; other < 16; other++)
+        {
+            bitmap[(c << 4) | other][0] = pair;
+            bitmap[(other << 4) | c][1] = pair;
+        }
+#endif
+
+        // 80 column entries with the colour as the foreground or the background
+        if (c < 8)
+        {
+            for (uint other = 0; other < 8; other++)
+            {
+                for (uint low = 0; low < 4; low++)
+                {
+                    for (uint x = 0; x < 2; x++)
+                    {
+                        uint as_fg = (other << 6) | (x << 5) | (c << 2) | low;
+                        uint as_bg = (c << 6) | (x << 5) | (other << 2) | low;
+                        vga80[as_fg] = vga80_lut_entry(shown, as_fg);
+                        vga80[as_bg] = vga80_lut_entry(shown, as_bg);
+                    }
+                }
+            }
+        }
+    }
+    if (artifact_changed)
+    {
+        build_artifact_lut(artifact_lut[parity], colours);
+    }
+    rs->vga80_lut = vga80;
+#if (BITMAP_MODE == 1)
+    rs->bitmap_lut = bitmap;
+#endif
+    rs->colours = colours;
+    rs->artifact_lut = artifact_lut[parity];
+    rs->ink = preset_colour(colours, rs->ink);
+    rs->ink_alt = preset_colour(colours, rs->ink_alt);
+    rs->paper = preset_colour(colours, rs->paper);
+}
+
+#if (BITMAP_MODE == 1)
+// Write one line of the bitmap as a single raw run with the extra border pixel first, like graphics_from_lut().
+// The bitmap is read a word at a time, the first pixels are in the low byte.
+static uint16_t *bitmap_line(const render_state_t *rs, uint16_t *p, uint16_t border_colour, uint row)
+{
+    *p++ = COMPOSABLE_RAW_RUN;
+    *p++ = border_colour;
+    *p++ = max_width + 1 - 3;
+
+    uint32_t *q = (uint32_t *)p;
+    const uint32_t *src = &bitmap_fb[row * BITMAP_WIDTH / 8];
+    for (uint i = 0; i < BITMAP_WIDTH / 8; i++)
+    {
+        uint32_t w = src[i];
+        for (uint byte = 0; byte < 4; byte++)
+        {
+            const uint32_t *pair = rs->bitmap_lut[w & 0xFF];
+            *q++ = pair[0];
+            *q++ = pair[1];
+            w >>= 8;
+        }
+    }
+    return (uint16_t *)q;
+}
+#endif
+
+// The text renderers can use the interpolators for the address arithmetic of the glyph
+// and colour lookups. Interpolators belong to a core, so they are set up at the start
+// of every scanline and either core can render text.
+//
+// 32 columns:
+//   interp0 lane0  upper case glyph row    plane + (ch & 0x3f)
+//   interp0 lane1  lower case glyph row    plane + (ch & 0x3f) + 64
+//
+// 80 columns:
+//   interp0 lane0  glyph row               plane + (ch & 0x7f)
+//   interp1 lane0  pixels 7 and 6          vp + ((b >> 6) & 3)
+//   interp1 lane1  pixels 5 and 4          vp + ((b >> 4) & 3)
+//   interp0 lane1  pixels 3 and 2          vp + ((b >> 2) & 3)
+// The pixel lanes are loaded with b << 2 to scale the index to the 4 byte LUT entries,
+// pixels 1 and 0 are cheaper to index directly.
+
+static inline void text_interp_lane(interp_hw_t *interp, uint lane, uint shift, uint mask_lsb, uint mask_msb, bool cross_input, const void *base)
+{
+    interp_config c = interp_default_config();
+    interp_config_set_shift(&c, shift);
+    interp_config_set_mask(&c, mask_lsb, mask_msb);
+    interp_config_set_cross_input(&c, cross_input);
+    interp_set_config(interp, lane, &c);
+    interp_set_base(interp, lane, (uintptr_t)base);
+}
+
+// Set the glyph lane accumulator to the character code
+static inline void text_interp_char(uint ch)
+{
+    interp_set_accumulator(interp0, 0, ch);
+}
+
+// Glyph row for the character set by text_interp_char(), lane 1 is lower case
+static inline uint8_t text_interp_glyph(uint lane)
+{
+    return *(const uint8_t *)interp_peek_lane_result(interp0, lane);
+}
+
+static inline void vga80_interp_colours(const uint32_t *vp)
+{
+    interp_set_base(interp1, 0, (uintptr_t)vp);
+    interp_set_base(interp1, 1, (uintptr_t)vp);
+    interp_set_base(interp0, 1, (uintptr_t)vp);
+}
+
+static inline void vga80_interp_setup(const uint8_t *plane, const uint32_t *vp)
+{
+    text_interp_lane(interp0, 0, 0, 0, 6, false, plane);
+    text_interp_lane(interp0, 1, 2, 2, 3, false, vp);
+    text_interp_lane(interp1, 0, 6, 2, 3, false, vp);
+    text_interp_lane(interp1, 1, 4, 2, 3, true, vp);
+}
+
+// Write the eight pixels of a glyph row as four pixel pairs from the LUT
+static inline uint32_t *vga80_pixels(uint32_t *q, const uint32_t *vp, uint b, const bool interp)
+{
+    if (interp)
+    {
+        uint b2 = b << 2;
+        interp_set_accumulator(interp1, 0, b2);
+        interp_set_accumulator(interp0, 1, b2);
+        *q++ = *(const uint32_t *)interp_peek_lane_result(interp1, 0);
+        *q++ = *(const uint32_t *)interp_peek_lane_result(interp1, 1);
+        *q++ = *(const uint32_t *)interp_peek_lane_result(interp0, 1);
+        *q++ = *(vp + (b & 3));
+    }
+    else
+    {
+        // Unroll the writing of the four pixel pairs
+        *q++ = *(vp + ((b >> 6) & 3));
+        *q++ = *(vp + ((b >> 4) & 3));
+        *q++ = *(vp + ((b >> 2) & 3));
+        *q++ = *(vp + ((b >> 0) & 3));
+    }
+    return q;
+}
+
+// Bytes of video memory the text modes wrap around in, whole rows of row_bytes
+static inline uint scroll_ring(uint wrap_rows, uint row_bytes, uint default_rows, uint max_bytes)
+{
+    uint ring = (wrap_rows ? wrap_rows : default_rows) * row_bytes;
+    return (ring > max_bytes) ? max_bytes - max_bytes % row_bytes : ring;
+}
+
+// Process Text mode, Semigraphics modes.
+//
+// 6847 control Atom    Dragon
+// INV          D7      D6
+// !A/G         PA4     PB7
+// !A/S         D6      D7
+// CSS          PC3     PB3
+// !INT/EXT     D6      PB4
+// GM0          PA5     PB4
+// GM1          PA6     PB5
+// GM2          PA7     PB6
+//
+// Due to the interaction between the SAM and the VDG on the Dragon, there are 3
+// extra semigraphics modes, SG8, SG12 and SG24, that split the character space up
+// into 8, 12 and 24 pixels. These pixels are still half a character width but are
+// 3, 2 and 1 scanlines high respectively.
+// This happens by programming the VDG in text mode and the SAM in graphics mode.
+// The memory used for these modes is incresed so that each vertical part of the
+// character space is 32 bytes apart in memory.
+// For example in the SG8 mode, the top 2 pixels are encoded in the first byte
+// the next 2 in the second byte and so on.
+// In this way the bytes per character line are 128, 192, and 384.
+//
+// Mode     Bytes/line  Bytes/chars colours resolution  memory
+// SG4      32          1           8       64x32       512
+// SG6      32          1           4       64x48       512
+// SG8      128         4           8       64x64       2048
+// SG12     192         6           8       64x96       3072
+// SG24     384         12          8       64x192      6144
+//
+// In SG8, SG12, SG24, the byte format is the same as the byte format for SG4
+// However if ralative_line_no is < 6 pixels 2 and 3 are plotted. If it is > 6
+// pixels 0 and 1 are plotted.
+//
+
+// Changed parameter memory to be called vram to avoid clash with global memory -- PHS
+//
+// do_text() is built twice by the compiler, with and without the interpolators.
+static __force_inline uint16_t *text(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs, uint relative_line_num, const volatile uint8_t *vram, uint16_t *p, bool is_debug, const bool interp)
+{
+    // Screen is 16 rows x 32 columns
+    // Each char is 12 x 8 pixels
+    // Note we divide ralative_line_number by 2 as we are double scanning each 6847 line to
+    // 2 VGA lines.
+    uint line = relative_line_num / 2 + (is_debug ? 0 : rs->scroll_fine);
+    uint row = line / 12;                                 // char row
+    uint sub_row = line % 12;                             // scanline within current char row
+    uint sgidx = is_debug ? TEXT_INDEX : rs->sgidx;       // index into semigraphics table
+    uint rows_per_char = 12 / sg_bytes_row[sgidx];        // bytes per character space vertically
+    const uint8_t *plane = rs->fontdata + sub_row * FONT_CHARS; // Font plane for sub_row
+
+    // Local copies of the render state so the loop below doesn't reload them
+    const uint16_t paper = rs->paper;
+    const uint16_t ink = rs->css ? rs->ink_alt : rs->ink;
+    const uint sg6_colour_offset = rs->css ? 4 : 0;
+    const bool support_lower = rs->support_lower;
+    const uint max_lower = rs->max_lower;
+
+    if (interp)
+    {
+        text_interp_lane(interp0, 0, 0, 0, 5, false, plane);
+        text_interp_lane(interp0, 1, 0, 0, 5, true, plane + 64);
+    }
+
+    // A 17th row shows at the bottom when the screen is fine scrolled
+    if (row <= 16)
+    {
+        // Calc start address for this row
+        uint row_bytes = chars_per_row * sg_bytes_row[sgidx];
+        uint vdu_address = (row_bytes * row) + (chars_per_row * (sub_row / rows_per_char));
+
+        // Apply the scroll registers, the address goes back by ring at wrap_col
+        uint ring = 0;
+        int wrap_col = chars_per_row;
+        if (!is_debug)
+        {
+            ring = scroll_ring(rs->scroll_wrap, row_bytes, 16, VID_MEM_SIZE);
+            vdu_address = (rs->scroll_start + vdu_address) % ring;
+            if (ring - vdu_address < chars_per_row)
+            {
+                wrap_col = ring - vdu_address;
+            }
+        }
+
+        for (int col = 0; col < 32; col++)
+        {
+            if (col == wrap_col)
+            {
+                vdu_address -= ring;
+            }
+            // Get character data from RAM and extract inv,ag,int/ext
+            uint ch = vram_get(vram, vdu_address + col);
+            bool inv = (ch & INV_MASK) ? true : false;
+            bool as = (ch & AS_MASK) ? true : false;
+            bool intext = GetIntExt(ch);
+
+            uint16_t fg_colour;
+            uint16_t bg_colour = paper;
+
+            // Deal with text mode first as we can decide this purely on the setting of the
+            // alpha/semi bit.
+            if (!as)
+            {
+                if (interp)
+                {
+                    text_interp_char(ch);
+                }
+                uint8_t b = interp ? text_interp_glyph(0) : plane[ch & 0x3f];
+
+                fg_colour = ink;
+
+                if (support_lower && ch >= LOWER_START && ch <= max_lower)
+                {
+                    b = interp ? text_interp_glyph(1) : plane[(ch & 0x3f) + 64];
+
+                    if (LOWER_INVERT)
+                    {
+                        bg_colour = fg_colour;
+                        fg_colour = paper;
+                    }
+                }
+                else if (inv)
+                {
+                    bg_colour = fg_colour;
+                    fg_colour = paper;
+                }
+
+                if (b == 0)
+                {
+                    *p++ = COMPOSABLE_COLOR_RUN;
+                    *p++ = bg_colour;
+                    *p++ = 16 - 3;
+                }
+                else
+                {
+                    // The internal character generator is only 6 bits wide, however external
+                    // character ROMS are 8 bits wide so we must handle them here
+                    uint16_t c = (b & 0x80) ? fg_colour : bg_colour;
+                    *p++ = COMPOSABLE_RAW_RUN;
+                    *p++ = c;
+                    *p++ = 16 - 3;
+                    *p++ = c;
+                    for (uint8_t mask = 0x40; mask > 0; mask = mask >> 1)
+                    {
+                        c = (b & mask) ? fg_colour : bg_colour;
+                        *p++ = c;
+                        *p++ = c;
+                    }
+                }
+            }
+            else // Semigraphics
+            {
+                uint colour_index;
+
+                if (as && intext)
+                {
+                    sgidx = SG6_INDEX; // SG6
+                }
+
+                colour_index = (SG6_INDEX == sgidx) ? (ch & SG6_COL_MASK) >> SG6_COL_SHIFT : (ch & SG4_COL_MASK) >> SG4_COL_SHIFT;
+
+                if (SG6_INDEX == sgidx)
+                {
+                    colour_index += sg6_colour_offset;
+                }
+
+                fg_colour = rs->colours[colour_index];
+
+                uint pix_row = (SG6_INDEX == sgidx) ? 2 - (sub_row / 4) : 1 - (sub_row / 6);
+
+                uint16_t pix0 = ((ch >> (pix_row * 2)) & 0x1) ? fg_colour : bg_colour;
+                uint16_t pix1 = ((ch >> (pix_row * 2)) & 0x2) ? fg_colour : bg_colour;
+                *p++ = COMPOSABLE_COLOR_RUN;
+                *p++ = pix1;
+                *p++ = 8 - 3;
+                *p++ = COMPOSABLE_COLOR_RUN;
+                *p++ = pix0;
+                *p++ = 8 - 3;
+            }
+        }
+    }
+    return p;
+}
+
+uint16_t *do_text(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs, uint relative_line_num, const volatile uint8_t *vram, uint16_t *p, bool is_debug)
+{
+    if (rs->text_interp)
+    {
+        return text(buffer, rs, relative_line_num, vram, p, is_debug, true);
+    }
+    return text(buffer, rs, relative_line_num, vram, p, is_debug, false);
+}
+
+void draw_color_bar(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
+{
+    const uint mode = rs->mode;
+    const uint line_num = scanvideo_scanline_number(buffer->scanline_id);
+    uint16_t *p = (uint16_t *)buffer->data;
+    int relative_line_num = line_num - vertical_offset;
+
+    const uint16_t *palette = rs->colours;
+    if (rs->css)
+    {
+        palette += 4;
+    }
+
+    // Graphics modes have a coloured border, text modes and the bitmap have a black border
+    uint16_t border_colour = ((mode & 1) && !rs->bitmap) ? palette[0] : 0;
+    uint debug_end = debug_start + rs->osd_rows * 12;
+
+    if (relative_line_num < 0 || line_num >= debug_end)
+    {
+        // Add top/bottom borders
+        p = add_border(p, border_colour, vga_width);
+    }
+    else
+    {
+
+        // Add left border
+        p = add_border(p, border_colour, horizontal_offset - 1);
+
+        if (line_num >= debug_start && line_num < debug_end) // Debug in 'text' mode
+        {
+            uint32_t start = time_us_32();
+            p = do_text(buffer, rs, (line_num - debug_start) * 2, osd_vram, p, true);
+            render_load[get_core_num()].osd_us += time_us_32() - start;
+        }
+#if (BITMAP_MODE == 1)
+        else if (rs->bitmap)
+        {
+            p = bitmap_line(rs, p, border_colour, relative_line_num / 2);
+        }
+#endif
+        else if (!(mode & 1)) // Alphanumeric or Semigraphics
+        {
+            if (relative_line_num >= 0 && relative_line_num < (16 * 24))
+            {
                 // p = do_text(buffer, relative_line_num, (char *)memory + GetVidMemBase(), p, false);
-                p = do_text(buffer, relative_line_num, GetVidMemBase(), p, false);
+                p = do_text(buffer, rs, relative_line_num, rs->vram, p, false);
+            }
+        }
+        else // Grapics modes
+        {
+            const int height = get_height(mode);
+            relative_line_num = (relative_line_num / 2) * height / 192;
+            if (relative_line_num >= 0 && relative_line_num < height)
+            {
+                uint vdu_address = bytes_per_row(mode) * relative_line_num;
+                size_t bp = vdu_address;
+
+                // The table is only good for the mode and colour set it was built for,
+                // which can change part way through a frame with RENDER_LATCH_PER_LINE
+                if (is_artifact(mode, rs->artifact))
+                {
+                    p = artifact_line(rs, p, border_colour, bp);
+                }
+                else if (rs->graphics_lut && rs->lut_mode == mode && rs->lut_css == rs->css)
+                {
+                    p = graphics_from_lut(rs, p, border_colour, bp);
+                }
+                else
+                {
+                    const uint pixel_count = get_width(mode);
+                    const uint pixel_width = max_width / pixel_count;
+
+                    // The extra border pixel makes up the 513 pixels of the old raw run
+                    rle_t rle;
+                    rle_begin(&rle, p, border_colour, 1);
+
+                    if (is_colour(mode))
+                    {
+                        uint32_t word = 0;
+                        for (uint pixel = 0; pixel < pixel_count; pixel++)
+                        {
+                            if ((pixel % 16) == 0)
+                            {
+                                word = vram_get32(rs->vram, bp);
+                                bp += 4;
+                            }
+                            uint x = (word >> 30) & 0b11;
+                            rle_push(&rle, palette[x], pixel_width);
+                            word = word << 2;
+                        }
+                    }
+                    else
+                    {
+                        uint16_t fg = palette[0];
+                        for (uint i = 0; i < pixel_count / 32; i++)
+                        {
+                            const uint32_t b = vram_get32(rs->vram, bp);
+                            bp += 4;
+                            for (uint32_t mask = 0x80000000; mask > 0; mask = mask >> 1)
+                            {
+                                rle_push(&rle, (b & mask) ? fg : 0, pixel_width);
+                            }
+                        }
+                    }
+
+                    p = rle_end(&rle);
+                }
+            }
+        }
+
+        // Add right border
+        p = add_border(p, border_colour, horizontal_offset);
+    }
+
+    end_scanline(buffer, p);
+}
+
+void reset_vga80()
+{
+    // memory[COL80_BASE] = COL80_OFF; // Normal text mode (vga80 off)
+    eb_set(COL80_BASE, COL80_OFF);
+    // memory[COL80_FG] = 0xB2;        // Foreground Green
+    eb_set(COL80_FG, 0xB2);
+    // memory[COL80_BG] = 0x00;        // Background Black
+    eb_set(COL80_BG, 0x00);
+    // memory[COL80_STAT] = 0x12;
+    eb_set(COL80_STAT, 0x12);
+    eb_memset(SCROLL_BASE, 0, SCROLL_LEN);
+    eb_set(PAGE_DISPLAY, 0);
+    eb_set(COPPER_CTRL, 0);
+    eb_set(EXT_CTRL, 0);
+    reset_palette();
+}
+
+void initialize_vga80()
+{
+    // Reset the VGA80 hardware
+    reset_vga80();
+    initialize_palette();
+}
+
+// Like do_text(), do_text_vga80() is built with and without the interpolators
+static __force_inline uint16_t *text_vga80(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs, uint relative_line_num, uint16_t *p, const bool interp)
+{
+    // Screen is 80 columns by 40 rows
+    // Each char is 12 x 8 pixels
+    uint line = relative_line_num + rs->scroll_fine;
+    uint row = line / 12;
+    uint sub_row = line % 12;
+
+    const uint8_t *plane = rs->fontdata + sub_row * FONT_CHARS;
+
+    // A 41st row shows at the bottom when the screen is fine scrolled
+    if (row <= 40)
+    {
+        // Compute the start address of the current row in the Atom framebuffer, after the
+        // scroll registers, the address goes back by ring at wrap_col
+        // volatile uint8_t *char_addr = memory + GetVidMemBase() + 80 * row;
+        uint ring = scroll_ring(rs->scroll_wrap, 80, 40, 80 * 40);
+        uint char_addr = (rs->scroll_start + 80 * row) % ring;
+        int wrap_col = (ring - char_addr < 80) ? ring - char_addr : 80;
+
+        // The VGA80 control registers
+        uint vga80_ctrl1 = rs->vga80_ctrl1;
+        uint vga80_ctrl2 = rs->vga80_ctrl2;
+
+        *p++ = COMPOSABLE_RAW_RUN;
+        *p++ = BLACK;   // Extra black pixel
+        *p++ = 642 - 3; //
+        *p++ = BLACK;   // Extra black pixel
+
+        // For efficiency, compute two pixels at a time using a lookup table
+        // p is now on a word boundary due to the extra pixels above
+        uint32_t *q = (uint32_t *)p;
+
+        if (vga80_ctrl1 & 0x08)
+        {
+            // Attribute mode enabled, attributes follow the characters in the frame buffer
+            // volatile uint8_t *attr_addr = char_addr + 80 * 40;
+            uint attr_addr = char_addr + 80 * 40;
+            uint shift = (sub_row >> 1) & 0x06; // 0, 2 or 4
+            // Compute these outside of the for loop for efficiency
+            uint smask0 = 0x10 >> shift;
+            uint smask1 = 0x20 >> shift;
+            uint ulmask = (sub_row == 10) ? 0xFF : 0x00;
+            if (interp)
+            {
+                vga80_interp_setup(plane, rs->vga80_lut);
+            }
+            for (int col = 0; col < 80; col++)
+            {
+                if (col == wrap_col)
+                {
+                    char_addr -= ring;
+                    attr_addr -= ring;
+                }
+                // uint ch = *char_addr++;
+                uint ch = vram_get(rs->vram, char_addr++);
+                // uint attr = *attr_addr++;
+                uint attr = vram_get(rs->vram, attr_addr++);
+                const uint32_t *vp = rs->vga80_lut + ((attr & 0x77) << 2);
+                if (attr & 0x80)
+                {
+                    // Semi Graphics
+                    uint32_t p1 = (ch & smask1) ? *(vp + 3) : *vp;
+                    uint32_t p0 = (ch & smask0) ? *(vp + 3) : *vp;
+                    // Unroll the writing of the four pixel pairs
+                    *q++ = p1;
+                    *q++ = p1;
+                    *q++ = p0;
+                    *q++ = p0;
+                }
+                else
+                {
+#if (PLATFORM == PLATFORM_DRAGON)
+                    ch ^= 0x60;
+#endif
+                    // Text
+                    if (interp)
+                    {
+                        text_interp_char(ch);
+                        vga80_interp_colours(vp);
+                    }
+                    uint8_t b = interp ? text_interp_glyph(0) : plane[ch & 0x7f];
+                    if (ch >= 0x80)
+                    {
+                        b = ~b;
+                    }
+                    // Underlined
+                    if (attr & 0x08)
+                    {
+                        b |= ulmask;
+                    }
+                    q = vga80_pixels(q, vp, b, interp);
+                }
             }
         }
-        else // Grapics modes
+        else
         {
-            const int height = get_height(mode);
-            relative_line_num = (relative_line_num / 2) * height / 192;
-            if (relative_line_num >= 0 && relative_line_num < height)
+            // Attribute mode disabled, use default colours from the VGA80 control registers:
+            //   bits 2..0 of VGA80_CTRL1 (#BDE4) are the default foreground colour
+            //   bits 2..0 of VGA80_CTRL2 (#BDE5) are the default background colour
+            uint attr = ((vga80_ctrl2 & 7) << 4) | (vga80_ctrl1 & 7);
+            const uint32_t *vp = rs->vga80_lut + (attr << 2);
+            if (interp)
             {
-                uint vdu_address = GetVidMemBase() + bytes_per_row(mode) * relative_line_num;
-                // uint32_t *bp = (uint32_t *)memory + vdu_address / 4;
-                size_t bp = vdu_address;
+                vga80_interp_setup(plane, vp);
+            }
+            for (int col = 0; col < 80; col++)
+            {
+                if (col == wrap_col)
+                {
+                    char_addr -= ring;
+                }
+                // uint ch = *char_addr++;
+                uint ch = vram_get(rs->vram, char_addr++);
+                bool inv = (ch & INV_MASK) ? true : false;
 
-                *p++ = COMPOSABLE_RAW_RUN;
-                *p++ = border_colour;
-                *p++ = 512 + 1 - 3;
+#if (PLATFORM == PLATFORM_DRAGON)
+                ch ^= 0x40;
+#endif
+                if (interp)
+                {
+                    text_interp_char(ch);
+                }
+                uint8_t b = interp ? text_interp_glyph(0) : plane[ch & 0x7f];
+                if (inv)
+                {
+                    b = ~b;
+                }
+                q = vga80_pixels(q, vp, b, interp);
+            }
+        }
+    }
+    // The above loops add 80 x 4 = 320 32-bit words, which is 640 16-bit words
+    return p + 640;
+}
+
+uint16_t *do_text_vga80(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs, uint relative_line_num, uint16_t *p)
+{
+    if (rs->text_interp)
+    {
+        return text_vga80(buffer, rs, relative_line_num, p, true);
+    }
+    return text_vga80(buffer, rs, relative_line_num, p, false);
+}
+
+void draw_color_bar_vga80(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
+{
+    const uint line_num = scanvideo_scanline_number(buffer->scanline_id);
+
+    uint16_t *p = do_text_vga80(buffer, rs, line_num, (uint16_t *)buffer->data);
+
+    end_scanline(buffer, p);
+}
+
+// Each core's render time budget for a scanline
+#define SCANLINE_BUDGET_US (line_us * (DUAL_CORE_RENDER + 1))
+
+#if (RENDER_GOVERNOR == 1)
+// Render debt that steps the quality down, half of what the queued scanlines can absorb
+#define GOVERNOR_DEBT_US (SCANLINE_BUDGET_US * PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT / 2)
+
+// Frames without any render debt before stepping back up. If the step up falls behind
+// within that many frames the wait doubles, up to GOVERNOR_HOLD_MAX.
+#define GOVERNOR_HOLD_FRAMES 120
+#define GOVERNOR_HOLD_MAX (GOVERNOR_HOLD_FRAMES << 5)
+
+volatile uint governor_level = GOV_FULL;
+static uint governor_stable = 0;
+static uint governor_hold = GOVERNOR_HOLD_FRAMES;
+static uint governor_up_frame = 0;
+static uint governor_change_frame = 0;
+
+volatile governor_event_t governor_log[GOVERNOR_LOG_LEN];
+volatile uint32_t governor_changes = 0;
+
+static void governor_step(uint frame, uint level, uint debt_us, uint dropped)
+{
+    volatile governor_event_t *event = &governor_log[governor_changes % GOVERNOR_LOG_LEN];
+    event->frame = frame;
+    event->from = governor_level;
+    event->to = level;
+    event->debt_us = (debt_us > UINT16_MAX) ? UINT16_MAX : debt_us;
+    event->dropped = dropped;
+    governor_changes++;
+    governor_level = level;
+    governor_stable = 0;
+    governor_change_frame = frame;
+}
+
+// Pick the quality for the next frame from the render debt and dropped scanlines of the
+// frame before last, the last one that's certain to be finished
+static void governor_update(uint frame, uint dropped)
+{
+    uint parity = frame & 1;
+    uint debt0 = render_load[0].frame_debt_us[parity];
+    uint debt1 = render_load[1].frame_debt_us[parity];
+    uint debt = (debt0 > debt1) ? debt0 : debt1;
+    render_load[0].frame_debt_us[parity] = 0;
+    render_load[1].frame_debt_us[parity] = 0;
+
+    // Until the frame before last is one latched after the last change
+    if (governor_changes && frame - governor_change_frame < 2)
+    {
+        return;
+    }
+
+    uint level = governor_level;
+    if (dropped || debt >= GOVERNOR_DEBT_US)
+    {
+        if (level < GOV_LEVELS - 1)
+        {
+            if (governor_up_frame && frame - governor_up_frame < governor_hold && governor_hold < GOVERNOR_HOLD_MAX)
+            {
+                governor_hold *= 2;
+            }
+            governor_up_frame = 0;
+            governor_step(frame, level + 1, debt, dropped);
+        }
+        governor_stable = 0;
+    }
+    else if (debt == 0)
+    {
+        if (++governor_stable >= governor_hold)
+        {
+            if (level > GOV_FULL)
+            {
+                governor_up_frame = frame;
+                governor_step(frame, level - 1, debt, dropped);
+            }
+            else
+            {
+                // Settled at full quality
+                governor_hold = GOVERNOR_HOLD_FRAMES;
+                governor_stable = 0;
+            }
+        }
+    }
+    else
+    {
+        governor_stable = 0;
+    }
+}
+
+// The last scanline each core drew, for GOV_LINE_REPEAT. In dual core mode the cores
+// mostly take alternate scanlines, so few get repeated.
+static uint32_t repeat_data[2][PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+static uint16_t repeat_used[2];
+static uint32_t repeat_id[2] = {UINT32_MAX, UINT32_MAX};
+
+// Copy the scanline above into an odd scanline if this core drew it
+static bool repeat_line(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
+{
+    uint core = get_core_num();
+    if (!rs->line_repeat || !(buffer->scanline_id & 1) || repeat_id[core] != buffer->scanline_id - 1)
+    {
+        return false;
+    }
+    memcpy(buffer->data, repeat_data[core], repeat_used[core] * sizeof(uint32_t));
+    buffer->data_used = repeat_used[core];
+    buffer->status = SCANLINE_OK;
+    return true;
+}
+
+// Keep an even scanline for repeat_line()
+static void keep_line(const scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
+{
+    uint core = get_core_num();
+    if (rs->line_repeat && !(buffer->scanline_id & 1))
+    {
+        memcpy(repeat_data[core], buffer->data, buffer->data_used * sizeof(uint32_t));
+        repeat_used[core] = buffer->data_used;
+        repeat_id[core] = buffer->scanline_id;
+    }
+}
+#else
+static inline void governor_update(uint frame, uint dropped)
+{
+}
+#endif
+
+// Latch the state that the 6502 can change with register writes, this is repeated for
+// every scanline if RENDER_LATCH_PER_LINE is set
+static void latch_line_state(render_state_t *rs)
+{
+    rs->mode = get_mode();
+    rs->css = alt_colour();
+    rs->vga80 = (eb_get(COL80_BASE) & (COL80_ON | COL80_BITMAP)) == COL80_ON;
+    rs->bitmap = (BITMAP_MODE == 1) && (eb_get(COL80_BASE) & COL80_BITMAP);
+    rs->vga80_ctrl1 = eb_get(COL80_FG);
+    rs->vga80_ctrl2 = eb_get(COL80_BG);
+    rs->scroll_start = eb_get(SCROLL_START) | (eb_get(SCROLL_START + 1) << 8);
+    rs->scroll_fine = eb_get(SCROLL_FINE) % 12;
+    rs->scroll_wrap = eb_get(SCROLL_WRAP);
+}
+
+// Bytes of video memory from the start of the frame buffer that the renderers read for
+// the state's mode
+static uint vram_span(const render_state_t *rs)
+{
+    if (rs->bitmap)
+    {
+        return 0;
+    }
+    if (rs->vga80)
+    {
+        return (rs->vga80_ctrl1 & COL80_ATTR) ? VGA80_MEM_SIZE : 80 * 40;
+    }
+    if (rs->mode & 1)
+    {
+        return bytes_per_row(rs->mode) * get_height(rs->mode);
+    }
+    return scroll_ring(rs->scroll_wrap, chars_per_row * sg_bytes_row[rs->sgidx], 16, VID_MEM_SIZE);
+}
+
+// Point the render state at the page of video memory to display, as far into the
+// captured video memory as leaves span bytes for the renderers
+static void latch_page(render_state_t *rs, uint span)
+{
+#if (EXT_VRAM == 1)
+    if (eb_get(EXT_CTRL) & EXT_DISPLAY)
+    {
+        // Keep everything the renderers can read inside extended memory
+        rs->page = MIN(eb_get(PAGE_DISPLAY), (EXT_VRAM_SIZE - VGA80_MEM_SIZE) / 256);
+        rs->vid_base = rs->page * 256;
+        rs->vram = &ext_vram[rs->vid_base * 2];
+        rs->vram_len = VGA80_MEM_SIZE;
+    }
+    else
+#endif
+    {
+        // The bus interface captures VGA80_MEM_SIZE bytes, which on the Dragon can run
+        // up to the end of memory
+        uint end = MIN(GetVidMemBase() + VGA80_MEM_SIZE, 0x10000);
+        uint last = (GetVidMemBase() + span < end) ? (end - GetVidMemBase() - span) / 256 : 0;
+        rs->page = MIN(eb_get(PAGE_DISPLAY), last);
+        rs->vid_base = GetVidMemBase() + rs->page * 256;
+        rs->vram = &_eb_memory[rs->vid_base * 2];
+        rs->vram_len = (end > rs->vid_base) ? end - rs->vid_base : 0;
+    }
+}
+
+// Latch the complete render state
+static void latch_render_state(render_state_t *rs)
+{
+    latch_line_state(rs);
+    rs->ink = ink;
+    rs->ink_alt = ink_alt;
+    rs->paper = paper;
+    rs->support_lower = support_lower;
+    rs->max_lower = max_lower;
+    rs->artifact = artifact;
+    rs->osd_rows = latch_osd();
+    rs->text_interp = (TEXT_INTERP == 1);
+    rs->sgidx = GetSAMSG();
+    latch_page(rs, vram_span(rs));
+    rs->line_repeat = false;
+    rs->copper_len = 0;
+    rs->sprite_lines = NULL;
+#if (RENDER_GOVERNOR == 1)
+    uint level = governor_level;
+    if (level >= GOV_NO_OSD)
+    {
+        rs->osd_rows = 0;
+    }
+    if (level >= GOV_SIMPLE_ARTIFACT)
+    {
+        rs->artifact = 0;
+    }
+    rs->line_repeat = (level >= GOV_LINE_REPEAT);
+#endif
+}
+
+// Copy a font into one of a frame parity's caches, unless it's already there
+static const uint8_t *use_font(uint parity, uint slot, uint font_no)
+{
+    if (cached_font[parity][slot] != font_no)
+    {
+        cache_font(font_cache[parity][slot], font_no);
+        cached_font[parity][slot] = font_no;
+    }
+    return &font_cache[parity][slot][0][0];
+}
 
-                const uint pixel_count = get_width(mode);
+// Latch the selected font, see switch_font()
+static void latch_font(render_state_t *rs, uint parity)
+{
+    rs->fonts[0] = use_font(parity, 0, fontno);
+    rs->fonts[1] = &font_cache[parity][1][0][0];
+    rs->fontdata = rs->fonts[0];
+}
 
-                if (is_colour(mode))
+// The copper display list of each frame parity
+#define COPPER_ENTRIES (COPPER_LEN / 4)
+static copper_entry_t copper_list[2][COPPER_ENTRIES];
+
+// Take the display list from the 6502's registers, dropping entries it can't apply, and
+// sort it by line. Call after latch_font(), as COPPER_FONT uses the same parity's caches.
+static void latch_copper(render_state_t *rs, uint parity)
+{
+    copper_entry_t *list = copper_list[parity];
+    uint len = 0;
+    if (eb_get(COPPER_CTRL) & COPPER_ENABLE)
+    {
+        for (uint i = 0; i < COPPER_ENTRIES; i++)
+        {
+            uint16_t address = COPPER_BASE + i * 4;
+            copper_entry_t entry = {eb_get(address) | (eb_get(address + 1) << 8), eb_get(address + 2), eb_get(address + 3)};
+            if (entry.line == 0xFFFF)
+            {
+                break;
+            }
+            if (entry.line >= vga_height || entry.reg >= COPPER_REGS)
+            {
+                continue;
+            }
+            if ((entry.reg == COPPER_INK || entry.reg == COPPER_PAPER || entry.reg == COPPER_INK_ALT) && entry.value >= NO_COLOURS)
+            {
+                continue;
+            }
+            if (entry.reg == COPPER_FONT)
+            {
+                // The value becomes 1 for the second font, 0 for the selected one
+                if (entry.value >= FONT_COUNT)
                 {
-                    uint32_t word = 0;
-                    for (uint pixel = 0; pixel < pixel_count; pixel++)
-                    {
-                        if ((pixel % 16) == 0)
-                        {
-                            // word = __builtin_bswap32(*bp++);
-                            word = eb_get32(bp);
-                            bp += 4;
-                        }
-                        uint x = (word >> 30) & 0b11;
-                        uint16_t colour = palette[x];
-                        if (pixel_count == 128)
-                        {
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                        }
-                        else if (pixel_count == 64)
-                        {
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                            *p++ = colour;
-                        }
-                        word = word << 2;
-                    }
+                    continue;
                 }
-                else
+                uint selected = cached_font[parity][0];
+                if (entry.value != selected)
                 {
-                    uint16_t fg = palette[0];
-                    for (uint i = 0; i < pixel_count / 32; i++)
-                    {
-                        // const uint32_t b = __builtin_bswap32(*bp++);
-                        const uint32_t b = eb_get32(bp);
-                        bp += 4;
-                        if (pixel_count == 256)
-                        {
-                            if (0 == artifact)
-                            {
-                                for (uint32_t mask = 0x80000000; mask > 0;)
-                                {
-                                    uint16_t colour = (b & mask) ? fg : 0;
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    mask = mask >> 1;
-
-                                    colour = (b & mask) ? fg : 0;
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    mask = mask >> 1;
-
-                                    colour = (b & mask) ? fg : 0;
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    mask = mask >> 1;
-
-                                    colour = (b & mask) ? fg : 0;
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    mask = mask >> 1;
-                                }
-                            }
-                            else
-                            {
-                                uint32_t word = b;
-                                for (uint apixel = 0; apixel < 16; apixel++)
-                                {
-                                    uint acol = (word >> 30) & 0b11;
-                                    uint16_t colour = art_palette[acol];
-
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    *p++ = colour;
-                                    *p++ = colour;
-
-                                    word = word << 2;
-                                }
-                            }
-                        }
-
-                        else if (pixel_count == 128)
-                        {
-                            for (uint32_t mask = 0x80000000; mask > 0; mask = mask >> 1)
-                            {
-                                uint16_t colour = (b & mask) ? palette[0] : 0;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                            }
-                        }
-                        else if (pixel_count == 64)
-                        {
-                            for (uint32_t mask = 0x80000000; mask > 0; mask = mask >> 1)
-                            {
-                                uint16_t colour = (b & mask) ? palette[0] : 0;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                                *p++ = colour;
-                            }
-                        }
-                    }
+                    use_font(parity, 1, entry.value);
                 }
+                entry.value = (entry.value != selected);
+            }
+
+            // Insertion sort, after any entries for the same line
+            uint j = len++;
+            while (j > 0 && list[j - 1].line > entry.line)
+            {
+                list[j] = list[j - 1];
+                j--;
+            }
+            list[j] = entry;
+        }
+    }
+    rs->copper = list;
+    rs->copper_len = len;
+}
+
+// Apply the display list entries up to a scanline. Each scanline starts again from the
+// start of the list, as in dual core mode they aren't rendered in order.
+static void copper_apply(render_state_t *rs, uint line_num)
+{
+    for (uint i = 0; i < rs->copper_len && rs->copper[i].line <= line_num; i++)
+    {
+        uint value = rs->copper[i].value;
+        switch (rs->copper[i].reg)
+        {
+        case COPPER_MODE:
+            rs->mode = value & 0x0F;
+            break;
+        case COPPER_CSS:
+            rs->css = value & 1;
+            break;
+        case COPPER_COL80:
+            rs->vga80 = (value & (COL80_ON | COL80_BITMAP)) == COL80_ON;
+            rs->bitmap = (BITMAP_MODE == 1) && (value & COL80_BITMAP);
+            break;
+        case COPPER_FG:
+            rs->vga80_ctrl1 = value;
+            break;
+        case COPPER_BG:
+            rs->vga80_ctrl2 = value;
+            break;
+        case COPPER_INK:
+            rs->ink = rs->colours[value];
+            break;
+        case COPPER_PAPER:
+            rs->paper = rs->colours[value];
+            break;
+        case COPPER_INK_ALT:
+            rs->ink_alt = rs->colours[value];
+            break;
+        case COPPER_SCROLL_L:
+            rs->scroll_start = (rs->scroll_start & 0xFF00) | value;
+            break;
+        case COPPER_SCROLL_H:
+            rs->scroll_start = (rs->scroll_start & 0x00FF) | (value << 8);
+            break;
+        case COPPER_FINE:
+            rs->scroll_fine = value % 12;
+            break;
+        case COPPER_FONT:
+            rs->fontdata = rs->fonts[value];
+            break;
+        }
+    }
+}
+
+// The most video memory the renderers read on any line, with the copper's changes
+static uint copper_span(const render_state_t *rs)
+{
+    uint span = vram_span(rs);
+    render_state_t line_state = *rs;
+    for (uint i = 0; i < rs->copper_len; i++)
+    {
+        copper_apply(&line_state, rs->copper[i].line);
+        span = MAX(span, vram_span(&line_state));
+    }
+    return span;
+}
+
+// Sprite registers as the 6502 last wrote them, from SPRITE_X on, and the sprite whose
+// registers are in the window at SPRITE_X
+static uint8_t sprite_regs[SPRITE_COUNT][SPRITE_REGS];
+static uint sprite_selected = 0;
+
+// The sprites of each frame parity and a bit for each sprite on each of the 192 lines
+// of the display area
+#define SPRITE_LINES 192
+static sprite_t sprite_frame[2][SPRITE_COUNT];
+static uint8_t sprite_lines[2][SPRITE_LINES];
+
+// Sprites that have overlapped another sprite, for each core
+static volatile uint8_t sprite_hits[2];
+
+// Called by the bus event handler for a write to the sprite registers. A register
+// write is stored for the sprite selected when it was queued, as the events are handled
+// in order. Selecting a sprite fills the window with its registers then sets
+// SPRITE_READY, the 6502 doesn't touch the window until then, like EXT_BANK.
+void sprite_write(uint16_t address)
+{
+    if (address == SPRITE_SELECT)
+    {
+        uint select = eb_get(SPRITE_SELECT);
+        if (select & SPRITE_READY)
+        {
+            return;
+        }
+        sprite_selected = select % SPRITE_COUNT;
+        for (uint i = 0; i < SPRITE_REGS; i++)
+        {
+            eb_set(SPRITE_X + i, sprite_regs[sprite_selected][i]);
+        }
+        eb_set(SPRITE_SELECT, select | SPRITE_READY);
+    }
+    else if (address < SPRITE_X + SPRITE_REGS)
+    {
+        sprite_regs[sprite_selected][address - SPRITE_X] = eb_get(address);
+    }
+}
+
+// Take the sprites from their registers and list which are on each line
+static void latch_sprites(render_state_t *rs, sprite_t *sprites, uint8_t *lines)
+{
+    rs->sprites = sprites;
+    rs->sprite_lines = NULL;
+    memset(lines, 0, SPRITE_LINES);
+    for (uint n = 0; n < SPRITE_COUNT; n++)
+    {
+        const uint8_t *regs = sprite_regs[n];
+        sprite_t *sprite = &sprites[n];
+        sprite->x = (int16_t)(regs[SPRITE_X - SPRITE_X] | (regs[SPRITE_X - SPRITE_X + 1] << 8));
+        sprite->y = (int16_t)(regs[SPRITE_Y - SPRITE_X] | (regs[SPRITE_Y - SPRITE_X + 1] << 8));
+        sprite->width = MIN(regs[SPRITE_WIDTH - SPRITE_X], SPRITE_MAX_WIDTH);
+        sprite->height = regs[SPRITE_HEIGHT - SPRITE_X];
+        sprite->key = regs[SPRITE_KEY - SPRITE_X];
+        sprite->pattern = regs[SPRITE_PATTERN - SPRITE_X] | (regs[SPRITE_PATTERN - SPRITE_X + 1] << 8);
+        if (!(regs[SPRITE_FLAGS - SPRITE_X] & SPRITE_ENABLE) || sprite->width == 0)
+        {
+            continue;
+        }
+        int top = MAX(sprite->y, 0);
+        int bottom = MIN(sprite->y + sprite->height, SPRITE_LINES);
+        for (int y = top; y < bottom; y++)
+        {
+            lines[y] |= 1 << n;
+        }
+        if (top < bottom && sprite->x > -(int)sprite->width && sprite->x < 256)
+        {
+            rs->sprite_lines = lines;
+        }
+    }
+}
+
+// Expand a finished scanline back to pixels, the inverse of the tokens written above
+static void expand_scanline(const scanvideo_scanline_buffer_t *buffer, uint16_t *pixels, uint max_pixels)
+{
+    const uint16_t *p = (const uint16_t *)buffer->data;
+    uint x = 0;
+    for (;;)
+    {
+        uint16_t token = *p++;
+        uint count;
+        if (token == COMPOSABLE_COLOR_RUN)
+        {
+            uint16_t colour = *p++;
+            count = *p++ + 3;
+            for (; count > 0 && x < max_pixels; count--)
+            {
+                pixels[x++] = colour;
+            }
+            continue;
+        }
+        else if (token == COMPOSABLE_RAW_RUN)
+        {
+            // The first pixel comes before the count
+            if (x < max_pixels)
+            {
+                pixels[x++] = *p;
+            }
+            p++;
+            count = *p++ + 3 - 1;
+        }
+        else if (token == COMPOSABLE_RAW_1P)
+        {
+            count = 1;
+        }
+        else if (token == COMPOSABLE_RAW_2P)
+        {
+            count = 2;
+        }
+        else
+        {
+            return;
+        }
+        // Pixels past the end are skipped, so the next token is still found
+        for (uint i = 0; i < count && x < max_pixels; i++)
+        {
+            pixels[x++] = p[i];
+        }
+        p += count;
+    }
+}
+
+// Draw the sprites over a scanline the renderers have finished. A line with sprites on
+// is expanded back to pixels, drawn over and sent as one raw run.
+static void draw_sprites(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
+{
+    uint line_num = scanvideo_scanline_number(buffer->scanline_id);
+    if (!rs->sprite_lines || line_num < vertical_offset || line_num >= vertical_offset + max_height)
+    {
+        return;
+    }
+    uint y = (line_num - vertical_offset) / 2;
+    uint on_line = rs->sprite_lines[y];
+    if (!on_line)
+    {
+        return;
+    }
+
+    // 640 is vga_width, and the end of line pixel
+    static uint16_t line_pixels[2][640 + 1];
+    uint16_t *pixels = line_pixels[get_core_num()];
+    expand_scanline(buffer, pixels, vga_width + 1);
+
+    // Sprites on each pixel so far, for the collisions
+    uint8_t cover[256];
+    memset(cover, 0, sizeof(cover));
+    uint hits = 0;
+
+    // Back to front, so sprite 0 is drawn last
+    for (int n = SPRITE_COUNT - 1; n >= 0; n--)
+    {
+        if (!(on_line & (1 << n)))
+        {
+            continue;
+        }
+        const sprite_t *sprite = &rs->sprites[n];
+        uint offset = sprite->pattern + (y - sprite->y) * sprite->width;
+        uint16_t *q = pixels + horizontal_offset;
+        for (int i = 0; i < sprite->width; i++)
+        {
+            int x = sprite->x + i;
+            uint8_t colour = sprite_patterns[(offset + i) % SPRITE_PATTERN_SIZE];
+            if (x < 0 || x >= 256 || colour == sprite->key || colour >= NO_COLOURS)
+            {
+                continue;
+            }
+            if (cover[x])
+            {
+                hits |= cover[x] | (1 << n);
             }
+            cover[x] |= 1 << n;
+            q[x * 2] = rs->colours[colour];
+            q[x * 2 + 1] = rs->colours[colour];
         }
+    }
+    if (hits)
+    {
+        sprite_hits[get_core_num()] |= hits;
+    }
 
-        // Add right border
-        p = add_border(p, border_colour, horizontal_offset);
+    // Raw run layout is token, first pixel, count - 3, remaining pixels
+    uint16_t *p = (uint16_t *)buffer->data;
+    *p++ = COMPOSABLE_RAW_RUN;
+    *p++ = pixels[0];
+    *p++ = vga_width - 3;
+    memcpy(p, pixels + 1, (vga_width - 1) * sizeof(uint16_t));
+    end_scanline(buffer, p + vga_width - 1);
+}
+
+#if (FRAME_SNAPSHOT == 1)
+// Copies of the frame buffer taken by DMA at the start of each frame, in the same
+// interleaved layout as _eb_memory. In dual core mode there's one for each frame parity
+// so that the copy for the next frame can't overwrite the one still being displayed.
+#define SNAPSHOT_COUNT (DUAL_CORE_RENDER + 1)
+static uint32_t vram_snapshot[SNAPSHOT_COUNT][SNAPSHOT_SIZE * 2 / 4];
+static uint snapshot_chan;
+
+static void snapshot_init()
+{
+    snapshot_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(snapshot_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    // Normal priority, so the 6502 bus channels are always served first
+    dma_channel_configure(snapshot_chan, &c, NULL, NULL, SNAPSHOT_SIZE * 2 / 4, false);
+}
+
+// Start copying the frame buffer into a snapshot and point the render state at it
+static void snapshot_start(render_state_t *rs, uint frame)
+{
+    uint32_t *snapshot = vram_snapshot[frame % SNAPSHOT_COUNT];
+    dma_channel_set_write_addr(snapshot_chan, snapshot, false);
+    dma_channel_set_trans_count(snapshot_chan, MIN(rs->vram_len, SNAPSHOT_SIZE) * 2 / 4, false);
+    dma_channel_set_read_addr(snapshot_chan, rs->vram, true);
+    rs->vram = (const volatile uint8_t *)snapshot;
+}
+
+// Wait for the copy started by snapshot_start() to finish, this is normally complete
+// long before the first line that reads video memory
+static inline void snapshot_wait()
+{
+    while (dma_channel_is_busy(snapshot_chan))
+    {
+        tight_loop_contents();
     }
+}
+#endif
 
-    // black pixel to end line
-    *p++ = COMPOSABLE_RAW_1P;
-    *p++ = 0;
-    // end of line with alignment padding
-    if (!(3u & (uintptr_t)p))
+// Render time histograms for each core, see record_render_time()
+volatile render_hist_t render_hist[2];
+
+// The renderer a scanline goes through, for the histograms
+static uint render_path(const render_state_t *rs, uint line_num)
+{
+    if (rs->vga80)
     {
-        *p++ = COMPOSABLE_EOL_SKIP_ALIGN;
+        return (rs->vga80_ctrl1 & COL80_ATTR) ? PATH_VGA80_ATTR : PATH_VGA80;
     }
-    else
+    if (line_num < vertical_offset || line_num >= debug_start)
     {
-        *p++ = COMPOSABLE_EOL_ALIGN;
+        return PATH_BORDER;
     }
-    *p++ = 0;
+    if (rs->bitmap)
+    {
+        return PATH_BITMAP;
+    }
+    if (!(rs->mode & 1))
+    {
+        return PATH_TEXT;
+    }
+    return is_artifact(rs->mode, rs->artifact) ? PATH_ARTIFACT : PATH_GRAPHICS;
+}
 
-    buffer->data_used = ((uint32_t *)p) - buffer->data;
-    assert(buffer->data_used < buffer->data_max);
+static void record_render_time(uint path, uint32_t us)
+{
+    volatile render_hist_t *hist = &render_hist[get_core_num()];
+    uint bucket = us / RENDER_HIST_US;
+    if (bucket >= RENDER_HIST_BUCKETS)
+    {
+        bucket = RENDER_HIST_BUCKETS - 1;
+    }
+    hist->count[path][bucket]++;
+    if (us > hist->max_us[path])
+    {
+        hist->max_us[path] = us;
+    }
+}
 
-    buffer->status = SCANLINE_OK;
+// Scanlines taken by scanvideo before they were rendered
+volatile uint32_t dropped_lines = 0;
+static uint frames_latched = 0;
+
+// Count the lines of the frame before last that were never rendered. All of its lines
+// have been handed out by the time the next frame starts, the frame in between may still
+// be in progress on the other core.
+static uint count_dropped(uint frame)
+{
+    uint parity = frame & 1;
+    uint lines = render_load[0].frame_lines[parity] + render_load[1].frame_lines[parity];
+    uint dropped = 0;
+    if (frames_latched >= 2 && lines < vga_height)
+    {
+        dropped = vga_height - lines;
+        dropped_lines += dropped;
+    }
+    render_load[0].frame_lines[parity] = 0;
+    render_load[1].frame_lines[parity] = 0;
+    frames_latched++;
+    return dropped;
 }
 
-void reset_vga80()
+// Render state for even and odd frames, so in dual core mode one core can latch the
+// next frame while the other is still finishing the last
+static render_state_t render_state[2];
+static volatile uint latched_frame = UINT32_MAX;
+static volatile uint latching_frame = UINT32_MAX;
+static spin_lock_t *frame_lock;
+
+// Build the state for a frame, outside frame_lock as the palette, copper, sprite and
+// font latches take a while
+static void latch_frame(render_state_t *rs, uint frame)
 {
-    // memory[COL80_BASE] = COL80_OFF; // Normal text mode (vga80 off)
-    eb_set(COL80_BASE, COL80_OFF);
-    // memory[COL80_FG] = 0xB2;        // Foreground Green
-    eb_set(COL80_FG, 0xB2);
-    // memory[COL80_BG] = 0x00;        // Background Black
-    eb_set(COL80_BG, 0x00);
-    // memory[COL80_STAT] = 0x12;
-    eb_set(COL80_STAT, 0x12);
+    governor_update(frame, count_dropped(frame));
+    latch_render_state(rs);
+    latch_font(rs, frame & 1);
+    latch_palette(rs, frame & 1);
+    latch_graphics_lut(rs, frame & 1);
+    latch_copper(rs, frame & 1);
+    if (rs->copper_len)
+    {
+        latch_page(rs, copper_span(rs));
+    }
+    latch_sprites(rs, sprite_frame[frame & 1], sprite_lines[frame & 1]);
+    eb_set(SPRITE_HITS, sprite_hits[0] | sprite_hits[1]);
+    sprite_hits[0] = 0;
+    sprite_hits[1] = 0;
+    eb_set(PAGE_SHOWN, rs->page);
+#if (FRAME_SNAPSHOT == 1)
+    snapshot_start(rs, frame);
+#endif
 }
 
-void initialize_vga80()
+// Per frame state latch, run by whichever core first sees a scanline of the new frame.
+// That core claims the frame under frame_lock, builds its state and then takes the lock
+// again only to publish it, while the other core waits with interrupts enabled.
+static const render_state_t *begin_frame(uint frame)
 {
-    // Reset the VGA80 hardware
-    reset_vga80();
-    // Use an LUT to allow two pixels to be calculated at once, taking account of the attribute byte for colours
-    //
-    // Bit  8  7  6  5  4  3  2  1   0
-    //      --bgc--  x  --fgc--  p1 p0
-    //
-    for (int i = 0; i < 128 * 4; i++)
+    render_state_t *rs = &render_state[frame & 1];
+    while (frame != latched_frame)
     {
-        vga80_lut[i] = ((i & 1) ? colour_palette_vga80[(i >> 2) & 7] : colour_palette_vga80[(i >> 6) & 7]) << 16;
-        vga80_lut[i] |= ((i & 2) ? colour_palette_vga80[(i >> 2) & 7] : colour_palette_vga80[(i >> 6) & 7]);
+        uint32_t save = spin_lock_blocking(frame_lock);
+        bool claimed = frame != latched_frame && latching_frame == latched_frame;
+        if (claimed)
+        {
+            latching_frame = frame;
+        }
+        spin_unlock(frame_lock, save);
+
+        if (claimed)
+        {
+            render_state_t state = *rs;
+            latch_frame(&state, frame);
+
+            save = spin_lock_blocking(frame_lock);
+            *rs = state;
+            latched_frame = frame;
+            spin_unlock(frame_lock, save);
+
+            // Wake core0 for frame_tasks()
+            frame_start_flag = true;
+            __sev();
+        }
+        else
+        {
+            tight_loop_contents();
+        }
     }
+    return rs;
 }
 
-uint16_t *do_text_vga80(scanvideo_scanline_buffer_t *buffer, uint relative_line_num, uint16_t *p)
+static void draw_scanline(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs)
 {
-    // Screen is 80 columns by 40 rows
-    // Each char is 12 x 8 pixels
-    uint row = relative_line_num / 12;
-    uint sub_row = relative_line_num % 12;
+#if (RENDER_GOVERNOR == 1)
+    if (repeat_line(buffer, rs))
+    {
+        return;
+    }
+#endif
+    if (rs->vga80)
+    {
+        draw_color_bar_vga80(buffer, rs);
+    }
+    else
+    {
+        draw_color_bar(buffer, rs);
+    }
+    draw_sprites(buffer, rs);
+#if (RENDER_GOVERNOR == 1)
+    keep_line(buffer, rs);
+#endif
+}
 
-    uint8_t *fd = fonts[fontno].fontdata + sub_row;
+// Publish where the beam is for the 6502. The buffer being rendered is queued some
+// lines ahead of the display, so ask scanvideo which line it will send next. In the
+// vertical blank that is line 0 of the next frame.
+static inline void update_raster()
+{
+    uint32_t next_id = scanvideo_get_next_scanline_id();
+    bool vblank = scanvideo_in_vblank();
+    eb_set16(RASTER_LINE, vblank ? vga_height : scanvideo_scanline_number(next_id));
+    eb_set(RASTER_STATUS, vblank ? RASTER_VBLANK : 0);
+    eb_set16(RASTER_FRAME, scanvideo_frame_number(next_id));
+}
 
-    if (row < 40)
+void render_scanline(scanvideo_scanline_buffer_t *scanline_buffer)
+{
+    uint32_t start = time_us_32();
+    update_raster();
+
+    uint frame = scanvideo_frame_number(scanline_buffer->scanline_id);
+    const render_state_t *rs = begin_frame(frame);
+#if (RENDER_LATCH_PER_LINE == 1)
+    render_state_t line_state = *rs;
+    latch_line_state(&line_state);
+    rs = &line_state;
+#endif
+    render_state_t copper_state;
+    uint line_num = scanvideo_scanline_number(scanline_buffer->scanline_id);
+    if (rs->copper_len && line_num >= rs->copper[0].line)
     {
-        // Compute the start address of the current row in the Atom framebuffer
-        // volatile uint8_t *char_addr = memory + GetVidMemBase() + 80 * row;
-        uint char_addr = GetVidMemBase() + 80 * row;
+        copper_state = *rs;
+        copper_apply(&copper_state, line_num);
+        rs = &copper_state;
+    }
+#if (RENDER_LATCH_PER_LINE == 1)
+    // The page is clamped for the mode the frame started in, a line in a mode that
+    // reads further is clamped again on its own, from live video memory
+    uint span = vram_span(rs);
+    if (span > rs->vram_len)
+    {
+        if (rs != &line_state)
+        {
+            line_state = *rs;
+        }
+        latch_page(&line_state, span);
+        rs = &line_state;
+    }
+#endif
+#if (FRAME_SNAPSHOT == 1)
+    snapshot_wait();
+#endif
 
-        // Read the VGA80 control registers
-        // uint vga80_ctrl1 = memory[COL80_FG];
-        uint vga80_ctrl1 = eb_get(COL80_FG);
-        // uint vga80_ctrl2 = memory[COL80_BG];
-        uint vga80_ctrl2 = eb_get(COL80_BG);
+    uint32_t draw_start = time_us_32();
+    draw_scanline(scanline_buffer, rs);
+    record_render_time(render_path(rs, line_num), time_us_32() - draw_start);
+    scanvideo_end_scanline_generation(scanline_buffer);
+
+    volatile render_load_t *load = &render_load[get_core_num()];
+    uint32_t busy = time_us_32() - start;
+    load->busy_us += busy;
+    load->lines++;
+    load->frame_lines[frame & 1]++;
+    if (busy >= line_us)
+    {
+        load->late++;
+    }
 
-        *p++ = COMPOSABLE_RAW_RUN;
-        *p++ = BLACK;   // Extra black pixel
-        *p++ = 642 - 3; //
-        *p++ = BLACK;   // Extra black pixel
+    // The queued scanlines let the renderers fall behind the beam for a while, the debt
+    // is how far behind this core is. The vertical blank is long enough to catch up.
+    uint32_t debt = (line_num == 0) ? busy : load->debt_us + busy;
+    load->debt_us = (debt > SCANLINE_BUDGET_US) ? debt - SCANLINE_BUDGET_US : 0;
+    if (load->debt_us > load->frame_debt_us[frame & 1])
+    {
+        load->frame_debt_us[frame & 1] = (load->debt_us > UINT16_MAX) ? UINT16_MAX : load->debt_us;
+    }
+}
 
-        // For efficiency, compute two pixels at a time using a lookup table
-        // p is now on a word boundary due to the extra pixels above
-        uint32_t *q = (uint32_t *)p;
+// Called by core0's main loop when it has nothing else to do. In dual core mode core0
+// renders any scanline that core1 hasn't already claimed, otherwise it sleeps until the
+// next interrupt or begin_frame() wakes it.
+void render_idle()
+{
+#if (DUAL_CORE_RENDER == 1)
+    scanvideo_scanline_buffer_t *scanline_buffer = scanvideo_begin_scanline_generation(false);
+    if (scanline_buffer)
+    {
+        render_scanline(scanline_buffer);
+    }
+#else
+    __wfe();
+#endif
+}
 
-        if (vga80_ctrl1 & 0x08)
+#if (RENDER_BENCH == 1) && (TEXT_INTERP == 1)
+// Print the cycles per scanline taken by the text renderers with and without the
+// interpolators, rendering whatever is in video memory, for render_bench()
+static void text_interp_compare()
+{
+    static uint32_t data[PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+    scanvideo_scanline_buffer_t buffer = {
+        .data = data,
+        .data_max = PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS};
+    static const char *names[] = {"32 column", "80 column", "80 column attribute"};
+    const uint lines = 480;
+    const uint mhz = clock_get_hz(clk_sys) / 1000000;
+
+    render_state_t rs;
+    latch_render_state(&rs);
+    latch_font(&rs, 0);
+    latch_palette(&rs, 0);
+    rs.mode = 0;
+    for (uint test = 0; test < 3; test++)
+    {
+        rs.vga80 = (test > 0);
+        rs.vga80_ctrl1 = (test == 2) ? COL80_ATTR : 0;
+        uint cycles[2];
+        for (uint interp = 0; interp < 2; interp++)
         {
-            // Attribute mode enabled, attributes follow the characters in the frame buffer
-            // volatile uint8_t *attr_addr = char_addr + 80 * 40;
-            uint attr_addr = char_addr + 80 * 40;
-            uint shift = (sub_row >> 1) & 0x06; // 0, 2 or 4
-            // Compute these outside of the for loop for efficiency
-            uint smask0 = 0x10 >> shift;
-            uint smask1 = 0x20 >> shift;
-            uint ulmask = (sub_row == 10) ? 0xFF : 0x00;
-            for (int col = 0; col < 80; col++)
+            rs.text_interp = interp;
+            uint64_t start = time_us_64();
+            for (uint line = 0; line < lines; line++)
             {
-                // uint ch = *char_addr++;
-                uint ch = eb_get(char_addr++);
-                // uint attr = *attr_addr++;
-                uint attr = eb_get(attr_addr++);
-                uint32_t *vp = vga80_lut + ((attr & 0x77) << 2);
-                if (attr & 0x80)
+                buffer.scanline_id = line;
+                if (rs.vga80)
                 {
-                    // Semi Graphics
-                    uint32_t p1 = (ch & smask1) ? *(vp + 3) : *vp;
-                    uint32_t p0 = (ch & smask0) ? *(vp + 3) : *vp;
-                    // Unroll the writing of the four pixel pairs
-                    *q++ = p1;
-                    *q++ = p1;
-                    *q++ = p0;
-                    *q++ = p0;
+                    draw_color_bar_vga80(&buffer, &rs);
                 }
                 else
                 {
-#if (PLATFORM == PLATFORM_DRAGON)
-                    ch ^= 0x60;
-#endif
-                    // Text
-                    uint8_t b = fd[(ch & 0x7f) * 12];
-                    if (ch >= 0x80)
-                    {
-                        b = ~b;
-                    }
-                    // Underlined
-                    if (attr & 0x08)
-                    {
-                        b |= ulmask;
-                    }
-                    // Unroll the writing of the four pixel pairs
-                    *q++ = *(vp + ((b >> 6) & 3));
-                    *q++ = *(vp + ((b >> 4) & 3));
-                    *q++ = *(vp + ((b >> 2) & 3));
-                    *q++ = *(vp + ((b >> 0) & 3));
+                    draw_color_bar(&buffer, &rs);
                 }
             }
+            cycles[interp] = (time_us_64() - start) * mhz / lines;
         }
-        else
-        {
-            // Attribute mode disabled, use default colours from the VGA80 control registers:
-            //   bits 2..0 of VGA80_CTRL1 (#BDE4) are the default foreground colour
-            //   bits 2..0 of VGA80_CTRL2 (#BDE5) are the default background colour
-            uint attr = ((vga80_ctrl2 & 7) << 4) | (vga80_ctrl1 & 7);
-            uint32_t *vp = vga80_lut + (attr << 2);
-            for (int col = 0; col < 80; col++)
-            {
-                // uint ch = *char_addr++;
-                uint ch = eb_get(char_addr++);
-                bool inv = (ch & INV_MASK) ? true : false;
+        printf("%-20s %5d cycles/line, %5d with interpolators\n", names[test], cycles[0], cycles[1]);
+    }
+}
+#endif
 
-#if (PLATFORM == PLATFORM_DRAGON)
-                ch ^= 0x40;
+#if (RENDER_BENCH == 1)
+// Benchmark firmware, see the atomvga_bench target. Core0 fills video memory with worst
+// case patterns, renders whole frames of each through the production renderers and
+// prints the cycles per scanline on the UART. Video output, the bus interface and the
+// sound engine are never started, so nothing else competes for the core or the bus.
+
+// Frames rendered from a warm XIP cache for each pattern
+#define BENCH_FRAMES 16
+
+// Video memory byte at offset for a pattern
+typedef uint8_t (*bench_fill_t)(uint offset);
+
+typedef struct
+{
+    const char *name;
+    bench_fill_t fill;
+    uint mode;         // VDG mode, see get_mode()
+    uint8_t artifact;
+    bool support_lower;
+    uint vga80_ctrl1;  // 0 for the 32 column modes, else COL80_ON plus COL80_FG or COL80_BITMAP
+} bench_pattern_t;
+
+static uint32_t bench_seed;
+
+static uint8_t bench_noise(uint offset)
+{
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return bench_seed >> 16;
+}
+
+static uint8_t bench_text(uint offset)
+{
+    return offset & 0x3f;
+}
+
+static uint8_t bench_inverse(uint offset)
+{
+    return INV_MASK | (offset & 0x3f);
+}
+
+static uint8_t bench_lower(uint offset)
+{
+    return LOWER_START + offset % LOWER_RANGE;
+}
+
+static uint8_t bench_sg6(uint offset)
+{
+    return AS_MASK | bench_noise(offset);
+}
+
+// Characters then, from 80 * 40, attributes: any colours, underlined, never semigraphics
+static uint8_t bench_underline(uint offset)
+{
+    return (offset < 80 * 40) ? bench_noise(offset) : (bench_noise(offset) & 0x77) | 0x08;
+}
+
+static const bench_pattern_t bench_patterns[] = {
+    {"text", bench_text, 0x0, 0, false, 0},
+    {"text inverse", bench_inverse, 0x0, 0, false, 0},
+    {"lower case", bench_lower, 0x0, 0, true, 0},
+    {"SG6", bench_sg6, 0x0, 0, false, 0},
+    {"CG6 noise", bench_noise, 0xD, 0, false, 0},
+    {"RG6 noise", bench_noise, 0xF, 0, false, 0},
+    {"RG6 artifact noise", bench_noise, 0xF, 1, false, 0},
+    {"80x40 noise", bench_noise, 0x0, 0, false, COL80_ON | 0x07},
+    {"80x40 attribute", bench_noise, 0x0, 0, false, COL80_ON | COL80_ATTR},
+    {"80x40 underline", bench_underline, 0x0, 0, false, COL80_ON | COL80_ATTR},
+#if (BITMAP_MODE == 1)
+    {"bitmap noise", bench_noise, 0x0, 0, false, COL80_BITMAP},
 #endif
-                uint8_t b = fd[(ch & 0x7f) * 12];
-                if (inv)
-                {
-                    b = ~b;
-                }
-                // Unroll the writing of the four pixel pairs
-                *q++ = *(vp + ((b >> 6) & 3));
-                *q++ = *(vp + ((b >> 4) & 3));
-                *q++ = *(vp + ((b >> 2) & 3));
-                *q++ = *(vp + ((b >> 0) & 3));
-            }
+};
+
+// SysTick counts down from 0xFFFFFF at the system clock, a scanline is a few thousand
+// cycles so a single wrap between readings is harmless
+static inline uint32_t bench_cycles()
+{
+    return systick_hw->cvr;
+}
+
+// Render one frame, returning the total cycles and updating the longest line and the
+// most scanline buffer words used
+static uint32_t bench_frame(scanvideo_scanline_buffer_t *buffer, const render_state_t *rs, uint32_t *max_cycles, uint *max_words)
+{
+    uint32_t total = 0;
+    for (uint line = 0; line < vga_height; line++)
+    {
+        buffer->scanline_id = line;
+        uint32_t start = bench_cycles();
+        if (rs->vga80)
+        {
+            draw_color_bar_vga80(buffer, rs);
+        }
+        else
+        {
+            draw_color_bar(buffer, rs);
+        }
+        uint32_t cycles = (start - bench_cycles()) & 0xFFFFFF;
+        total += cycles;
+        if (cycles > *max_cycles)
+        {
+            *max_cycles = cycles;
+        }
+        if (buffer->data_used > *max_words)
+        {
+            *max_words = buffer->data_used;
         }
     }
-    // The above loops add 80 x 4 = 320 32-bit words, which is 640 16-bit words
-    return p + 640;
+    return total;
 }
 
-void draw_color_bar_vga80(scanvideo_scanline_buffer_t *buffer)
+static void bench_pattern(const bench_pattern_t *pattern, uint budget)
 {
-    const uint line_num = scanvideo_scanline_number(buffer->scanline_id);
+    static uint32_t data[PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+    scanvideo_scanline_buffer_t buffer = {
+        .data = data,
+        .data_max = PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS};
 
-    uint16_t *p = do_text_vga80(buffer, line_num, (uint16_t *)buffer->data);
-
-    if (line_num == 0)
+    bench_seed = 1;
+    for (uint offset = 0; offset < SNAPSHOT_SIZE; offset++)
     {
-        check_command();
-        update_debug_text();
-        check_reset();
+        eb_set(GetVidMemBase() + offset, pattern->fill(offset));
     }
-
-    // black pixel to end line
-    *p++ = COMPOSABLE_RAW_1P;
-    *p++ = 0;
-    // end of line with alignment padding
-    if (!(3u & (uintptr_t)p))
+#if (BITMAP_MODE == 1)
+    for (uint offset = 0; offset < BITMAP_SIZE; offset++)
     {
-        *p++ = COMPOSABLE_EOL_SKIP_ALIGN;
+        ((uint8_t *)bitmap_fb)[offset] = pattern->fill(offset);
     }
-    else
+#endif
+
+    render_state_t rs;
+    latch_render_state(&rs);
+    latch_font(&rs, 0);
+    rs.mode = pattern->mode;
+    rs.css = false;
+    rs.artifact = pattern->artifact;
+    rs.support_lower = pattern->support_lower;
+    rs.vga80 = (pattern->vga80_ctrl1 & COL80_ON) != 0;
+    rs.bitmap = (pattern->vga80_ctrl1 & COL80_BITMAP) != 0;
+    rs.vga80_ctrl1 = pattern->vga80_ctrl1 & ~(COL80_ON | COL80_BITMAP);
+    rs.vga80_ctrl2 = 0;
+    rs.osd_rows = 0;
+    latch_palette(&rs, 0);
+    latch_graphics_lut(&rs, 0);
+
+    // The first frame runs from a cold XIP cache, as after a mode change
+    uint32_t max_cycles = 0;
+    uint max_words = 0;
+    xip_ctrl_hw->flush = 1;
+    (void)xip_ctrl_hw->flush;
+    uint32_t cold = bench_frame(&buffer, &rs, &max_cycles, &max_words) / vga_height;
+
+    uint64_t warm = 0;
+    for (uint frame = 0; frame < BENCH_FRAMES; frame++)
     {
-        *p++ = COMPOSABLE_EOL_ALIGN;
+        warm += bench_frame(&buffer, &rs, &max_cycles, &max_words);
     }
-    *p++ = 0;
+    warm /= BENCH_FRAMES * vga_height;
 
-    buffer->data_used = ((uint32_t *)p) - buffer->data;
-    assert(buffer->data_used < buffer->data_max);
+    printf("%-20s %-10s %6lu %6lu %6lu %4lu%% %6u\n", pattern->name, render_path_names[render_path(&rs, vga_height / 2)],
+           (unsigned long)cold, (unsigned long)warm, (unsigned long)max_cycles,
+           (unsigned long)(max_cycles * 100 / budget), max_words);
+}
 
-    buffer->status = SCANLINE_OK;
+void render_bench()
+{
+    initialize_vga80();
+
+    // SysTick free running from the processor clock
+    systick_hw->rvr = 0xFFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;
+
+    const uint mhz = clock_get_hz(clk_sys) / 1000000;
+    const uint budget = mhz * 31778 / 1000; // cycles in a 640x480 scanline
+
+    while (true)
+    {
+        printf("\nRender benchmark, %u MHz, %u cycles per scanline\n", mhz, budget);
+        printf("%-20s %-10s %6s %6s %6s %5s %6s\n", "pattern", "path", "cold", "warm", "max", "load", "words");
+        for (uint i = 0; i < count_of(bench_patterns); i++)
+        {
+            bench_pattern(&bench_patterns[i], budget);
+        }
+#if (TEXT_INTERP == 1)
+        printf("\n");
+        text_interp_compare();
+#endif
+        sleep_ms(10000);
+    }
 }
+#endif
 
 void core1_func()
 {
     // initialize video and interrupts on core 1
     initialize_vga80();
+    frame_lock = spin_lock_init(spin_lock_claim_unused(true));
+#if (FRAME_SNAPSHOT == 1)
+    snapshot_init();
+#endif
     scanvideo_setup(&vga_mode);
     initialiseIO();
     scanvideo_timing_enable(true);
     sem_release(&video_initted);
+
     while (true)
     {
-        // uint vga80 = memory[COL80_BASE] & COL80_ON;
-        uint vga80 = eb_get(COL80_BASE) & COL80_ON;
         scanvideo_scanline_buffer_t *scanline_buffer = scanvideo_begin_scanline_generation(true);
-        if (vga80)
-        {
-            draw_color_bar_vga80(scanline_buffer);
-        }
-        else
-        {
-            draw_color_bar(scanline_buffer);
-        }
-        scanvideo_end_scanline_generation(scanline_buffer);
+        render_scanline(scanline_buffer);
     }
 }
@@ -54,7 +54,9 @@ uint16_t colour_palette_atom[NO_COLOURS] = {
 #define DEF_INK_ALT ORANGE
 
 
-uint16_t colour_palette_vga80[8] = {
+// The palette registers at reset, see PALETTE_BASE. The first 8 are the 80 column
+// colours, the bitmap mode uses all 16 and the 6847 colours are in vdg_palette_entry.
+uint16_t colour_palette_default[16] = {
     BLACK,
     BLUE,
     GREEN,
@@ -62,9 +64,21 @@ uint16_t colour_palette_vga80[8] = {
     RED,
     MAGENTA,
     YELLOW,
-    WHITE
+    WHITE,
+    WHITE_1,
+    BLUE_2,
+    GREEN_2,
+    GREEN_2 | BLUE_2,
+    RED_2,
+    RED_2 | BLUE_2,
+    ORANGE,
+    WHITE_2
 };
 
+// The palette entry that shows each of colour_palette_atom, which is what the 6847
+// modes, the artifact colours and the FG/BG presets draw with
+const uint8_t vdg_palette_entry[NO_COLOURS] = {2, 6, 1, 4, 7, 3, 5, 14, 0};
+
 uint16_t colour_palette_improved[4] = {
     BLACK,
     YELLOW,
@@ -72,18 +86,10 @@ uint16_t colour_palette_improved[4] = {
     MAGENTA,
 };
 
-uint16_t colour_palette_artifact1[4] = {
-    BLACK,
-    BLUE,
-    ORANGE,
-    WHITE,
-};
-
-uint16_t colour_palette_artifact2[4] = {
-    BLACK,
-    ORANGE,
-    BLUE,
-    WHITE,
+// The artifact colours of each palette, as indexes into colour_palette_atom
+const uint8_t artifact_colours[2][4] = {
+    {IDX_BLACK, IDX_BLUE, IDX_ORANGE, IDX_WHITE},
+    {IDX_BLACK, IDX_ORANGE, IDX_BLUE, IDX_WHITE},
 };
 
 
@@ -109,14 +115,12 @@ const uint sg_bytes_row[5]  = {1, 4, 6, 12, 1};
 #define SG24_INDEX  3
 #define SG6_INDEX   4
 
-uint16_t *colour_palette = colour_palette_atom;
-
 //                             0  1a   1   2a    2   3a    3   4a    4
 //                             0  1    2    3    4    5    6    7    8
 const uint width_lookup[9] =  {32, 64, 128, 128, 128, 128, 128, 128, 256};
 const uint height_lookup[9] = {16, 64,  64,  64,  96,  96, 192, 192, 192};
 
-inline bool is_colour(uint mode);
+bool is_colour(uint mode);
 
 uint get_width(uint mode)
 {
@@ -135,8 +139,202 @@ uint bytes_per_row(uint mode)
     return is_colour(mode) ? get_width(mode) * 2 / 8 : get_width(mode) / 8;
 };
 
+// Set to 1 to have core0 render scanlines alongside core1, each core takes the next
+// scanline as soon as it is free
+#ifndef DUAL_CORE_RENDER
+#define DUAL_CORE_RENDER 0
+#endif
+
+// Set to 1 to re-read the mode, CSS and 80 column registers for every scanline rather
+// than once per frame, for software that changes mode part way down the screen
+#ifndef RENDER_LATCH_PER_LINE
+#define RENDER_LATCH_PER_LINE 0
+#endif
+
+// Set to 1 to render each frame from a copy of the frame buffer taken by DMA at the
+// start of the frame, so 6502 writes can't tear the displayed frame
+#ifndef FRAME_SNAPSHOT
+#define FRAME_SNAPSHOT 0
+#endif
+
+// Bytes of video memory the renderers can read, the 80x40 attribute mode has 3200
+// characters then 3200 attributes, more than the 6847's VID_MEM_SIZE
+#define VGA80_MEM_SIZE (80 * 40 * 2)
+
+// Bytes of video memory in the snapshot
+#define SNAPSHOT_SIZE VGA80_MEM_SIZE
+
+// Set to 1 for extended video memory in the Pico, see EXT_WINDOW
+#ifndef EXT_VRAM
+#define EXT_VRAM 0
+#endif
+
+// Bytes of extended video memory. It takes twice this in RAM, it is interleaved like
+// _eb_memory so the renderers can read it directly.
+#ifndef EXT_VRAM_SIZE
+#define EXT_VRAM_SIZE 0x4000
+#endif
+
+// Set to 1 for the 16 colour bitmap mode, see COL80_BITMAP, which takes BITMAP_SIZE
+// bytes of RAM for the bitmap
+#ifndef BITMAP_MODE
+#define BITMAP_MODE 0
+#endif
+
+// Set to 0 to render text without the interpolators
+#ifndef TEXT_INTERP
+#define TEXT_INTERP 1
+#endif
+
+// Set to 0 to expand the graphics modes one pixel at a time, coalescing runs of the same
+// colour, instead of from a lookup table
+#ifndef GRAPHICS_LUT
+#define GRAPHICS_LUT 1
+#endif
+
+// Set to 0 to turn off the render governor, which steps down to cheaper rendering when
+// the renderers fall behind the beam and back up when they keep up again
+#ifndef RENDER_GOVERNOR
+#define RENDER_GOVERNOR 1
+#endif
+
+// Set to 1 to build the render benchmark instead of the display, see the atomvga_bench
+// target in CMakeLists.txt
+#ifndef RENDER_BENCH
+#define RENDER_BENCH 0
+#endif
+
+// Set to 1 to have the Pico serve 6502 reads of video memory instead of only copying
+// its writes, so the 6502 reads back what the blitter wrote. The 6502's own video RAM
+// must then be disabled or removed.
+#ifndef SERVE_VIDEO_RAM
+#define SERVE_VIDEO_RAM 0
+#endif
+
+// A copper display list entry, see COPPER_BASE
+typedef struct
+{
+    uint16_t line;
+    uint8_t reg;
+    uint8_t value;
+} copper_entry_t;
+
+// A sprite as latched for a frame, see SPRITE_BASE
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    uint8_t width;
+    uint8_t height;
+    uint8_t key;
+    uint16_t pattern;
+} sprite_t;
+
+// Everything the renderers need, latched once per frame so that changes made by the
+// 6502 or core0 part way through a frame can't tear it
+typedef struct
+{
+    uint mode;         // VDG mode, see get_mode()
+    bool css;          // colour set select, see alt_colour()
+    bool vga80;        // 80 column mode enabled
+    bool bitmap;       // 16 colour bitmap enabled, see COL80_BITMAP
+    uint vga80_ctrl1;  // COL80_FG
+    uint vga80_ctrl2;  // COL80_BG
+    uint16_t ink;
+    uint16_t ink_alt;
+    uint16_t paper;
+    bool support_lower;
+    uint8_t max_lower;
+    uint8_t artifact;
+    uint osd_rows;     // rows of debug and performance overlay
+    const uint8_t *fontdata; // font being drawn, FONT_ROWS planes of FONT_CHARS bytes
+    const uint8_t *fonts[2]; // selected font and COPPER_FONT's second, see latch_font()
+    uint page;         // page of video memory displayed, see PAGE_DISPLAY
+    size_t vid_base;   // GetVidMemBase() plus the page, or the page of extended memory
+    const volatile uint8_t *vram; // frame buffer in _eb_memory, ext_vram or the snapshot
+    uint vram_len;     // bytes from vram that hold video memory, see latch_page()
+    uint sgidx;        // semigraphics mode from the SAM, see GetSAMSG()
+    bool text_interp;  // use the interpolators for text
+    const uint32_t *graphics_lut; // graphics mode pixel table, NULL if there isn't one
+    const uint32_t *vga80_lut; // 80 column pixel pairs for the palette, see latch_palette()
+    const uint32_t (*bitmap_lut)[2]; // bitmap pixel pairs for the palette
+    const uint16_t *colours; // colour_palette_atom as the palette shows it
+    const uint32_t (*artifact_lut)[16][2]; // artifact pixel pairs of both palettes
+    uint16_t lut_uniform; // nibbles whose graphics_lut entry is one colour
+    uint lut_mode;     // mode and colour set graphics_lut was built for
+    bool lut_css;
+    bool line_repeat;  // odd scanlines copy the one above, see GOV_LINE_REPEAT
+    uint scroll_start; // scroll registers, see SCROLL_START
+    uint scroll_fine;
+    uint scroll_wrap;
+    const copper_entry_t *copper; // display list sorted by line, see latch_copper()
+    uint copper_len;
+    const sprite_t *sprites; // sprites and the sprites on each line, see latch_sprites()
+    const uint8_t *sprite_lines; // NULL if there are none
+} render_state_t;
+
+// Scanline rendering load for one core
+typedef struct
+{
+    uint32_t busy_us; // time spent rendering
+    uint32_t lines;   // scanlines rendered
+    uint32_t late;    // scanlines that took longer than a scanline to render
+    uint32_t osd_us;  // time spent rendering the overlay
+    uint16_t frame_lines[2]; // scanlines rendered of each frame parity, see count_dropped()
+    uint32_t debt_us; // render time beyond the scanline time not yet caught up
+    uint16_t frame_debt_us[2]; // most debt_us reached in each frame parity
+} render_load_t;
+
+// Render quality levels of the governor, each also makes the savings of the ones above
+enum governor_level
+{
+    GOV_FULL,            // everything drawn
+    GOV_NO_OSD,          // the overlay isn't drawn
+    GOV_SIMPLE_ARTIFACT, // artifacted graphics drawn as plain two colour graphics
+    GOV_LINE_REPEAT,     // odd scanlines copy the one above
+    GOV_LEVELS
+};
+
+// A change of governor level, see governor_update()
+typedef struct
+{
+    uint32_t frame;
+    uint8_t from;
+    uint8_t to;
+    uint16_t debt_us;  // most render debt in the frame that triggered it
+    uint16_t dropped;  // scanlines dropped in that frame
+} governor_event_t;
+
+// Governor changes kept for print_stats()
+#define GOVERNOR_LOG_LEN 4
+
+// Renderers timed by the histograms, see render_path()
+enum render_path
+{
+    PATH_BORDER,     // borders and the overlay
+    PATH_TEXT,       // do_text(), text and semigraphics
+    PATH_GRAPHICS,   // graphics modes
+    PATH_ARTIFACT,   // artifacted graphics
+    PATH_VGA80,      // 80 column text
+    PATH_VGA80_ATTR, // 80 column text with attributes
+    PATH_BITMAP,     // bitmap_line(), the 16 colour bitmap
+    RENDER_PATHS
+};
+
+// Histogram buckets are RENDER_HIST_US wide, the last one also counts anything longer
+#define RENDER_HIST_BUCKETS 16
+#define RENDER_HIST_US 2
+
+// Time taken by draw_color_bar() or draw_color_bar_vga80() for one core
+typedef struct
+{
+    uint32_t count[RENDER_PATHS][RENDER_HIST_BUCKETS];
+    uint32_t max_us[RENDER_PATHS];
+} render_hist_t;
+
 #define COL80_OFF   0x00
 #define COL80_ON    0x80
+#define COL80_BITMAP 0x40
 #define COL80_ATTR  0x08
 
 #endif /* ATOMVGA_H_ */
@@ -16,7 +16,7 @@
 //
 // the lower case have true decenders and match the style of the upper case
 
-uint8_t fontdata_6847[] =
+const uint8_t fontdata_6847[] =
 {
     0x00, 0x00, 0x00, 0x1C, 0x22, 0x02, 0x1A, 0x2A, 0x2A, 0x1C, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x08, 0x14, 0x22, 0x22, 0x3E, 0x22, 0x22, 0x00, 0x00,
@@ -123,7 +123,7 @@ uint8_t fontdata_6847[] =
 // It used ntsc_round_fontdata8x12 from MAME, shifter up one pixel and
 // right one pixel so it matches the alignent of the 6847T1.
 
-uint8_t fontdata_gime[] =
+const uint8_t fontdata_gime[] =
 {
     0x00, 0x1C, 0x22, 0x02, 0x1A, 0x26, 0x26, 0x1C, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x08, 0x14, 0x22, 0x22, 0x3E, 0x22, 0x22, 0x00, 0x00, 0x00, 0x00,
@@ -229,7 +229,7 @@ uint8_t fontdata_gime[] =
 // matches photos on the internet of real CoCo2 machines with the XC80652P,
 // Motorola's pre-release version of the MC6847T1.
 
-uint8_t fontdata_6847t1[] = {
+const uint8_t fontdata_6847t1[] = {
     0x00, 0x1C, 0x22, 0x02, 0x1A, 0x26, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x08, 0x14, 0x22, 0x22, 0x3E, 0x22, 0x22, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x3C, 0x12, 0x12, 0x1C, 0x12, 0x12, 0x3C, 0x00, 0x00, 0x00, 0x00,
@@ -329,7 +329,7 @@ uint8_t fontdata_6847t1[] = {
 };
 
 // Dragon Alpha bootrom font
-uint8_t fontdata_dalpha[] =
+const uint8_t fontdata_dalpha[] =
 {
     0x00, 0x00, 0x1C, 0x22, 0x4D, 0x55, 0x56, 0x5C, 0x22, 0x1C, 0x00, 0x00, 
     0x00, 0x00, 0x08, 0x1C, 0x36, 0x63, 0x7F, 0x63, 0x63, 0x00, 0x00, 0x00, 
@@ -461,7 +461,7 @@ uint8_t fontdata_dalpha[] =
     0x00, 0x00, 0x30, 0xB0, 0xB6, 0x36, 0xB6, 0xBF, 0x86, 0x06, 0x00, 0x00 
 };
 
-uint8_t fontdata_BBC[] =
+const uint8_t fontdata_BBC[] =
 {
     0x00, 0x00, 0x3C, 0x66, 0x6E, 0x6A, 0x6E, 0x60, 0x3C, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x3C, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 
@@ -561,7 +561,7 @@ uint8_t fontdata_BBC[] =
     0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00 
 };
 
-uint8_t fontdata_CGA_thick[] =
+const uint8_t fontdata_CGA_thick[] =
 {
     0x00, 0x00, 0x7C, 0xC6, 0xDE, 0xDE, 0xDE, 0xC0, 0x78, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x30, 0x78, 0xCC, 0xCC, 0xFC, 0xCC, 0xCC, 0x00, 0x00, 0x00, 
@@ -694,7 +694,7 @@ uint8_t fontdata_CGA_thick[] =
 };
 
 
-uint8_t fontdata_CGA_thin[] =
+const uint8_t fontdata_CGA_thin[] =
 {
     0x00, 0x00, 0x3C, 0x42, 0x5E, 0x52, 0x5E, 0x40, 0x3C, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x18, 0x24, 0x42, 0x42, 0x7E, 0x42, 0x42, 0x00, 0x00, 0x00, 
@@ -826,7 +826,7 @@ uint8_t fontdata_CGA_thin[] =
     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-uint8_t fontdata_D200E[] =
+const uint8_t fontdata_D200E[] =
 {
     0x00, 0x00, 0x00, 0x1C, 0x22, 0x26, 0x2A, 0x24, 0x20, 0x1C, 0x00, 0x00, 
     0x00, 0x00, 0x00, 0x08, 0x14, 0x22, 0x22, 0x3E, 0x22, 0x22, 0x00, 0x00, 
@@ -958,7 +958,7 @@ uint8_t fontdata_D200E[] =
     0x00, 0x00, 0x10, 0x08, 0x00, 0x22, 0x22, 0x22, 0x22, 0x1D, 0x00, 0x00
 };
 
-uint8_t fontdata_saa5050[] =
+const uint8_t fontdata_saa5050[] =
 {
     0x00, 0x00, 0x38, 0x44, 0x5C, 0x54, 0x5C, 0x40, 0x38, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x10, 0x28, 0x44, 0x44, 0x7C, 0x44, 0x44, 0x00, 0x00, 0x00, 
@@ -1058,7 +1058,7 @@ uint8_t fontdata_saa5050[] =
     0x00, 0x00, 0x7C, 0x7C, 0x7C, 0x7C, 0x7C, 0x7C, 0x7C, 0x00, 0x00, 0x00 
 };
 
-uint8_t fontdata_spectrum[] =
+const uint8_t fontdata_spectrum[] =
 {
     0x00, 0x00, 0x00, 0x3C, 0x4A, 0x56, 0x5E, 0x40, 0x3C, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x00, 0x3C, 0x42, 0x42, 0x7E, 0x42, 0x42, 0x00, 0x00, 0x00, 
@@ -1158,25 +1158,31 @@ uint8_t fontdata_spectrum[] =
     0x00, 0x00, 0x3C, 0x42, 0x99, 0xA1, 0xA1, 0x99, 0x42, 0x3C, 0x00, 0x00 
 };
 
+// Each glyph is 12 bytes, one per row, and a font has up to 128 glyphs
+#define FONT_ROWS       12
+#define FONT_CHARS      128
+
 typedef struct 
 {
-    uint8_t *fontdata;
+    const uint8_t *fontdata;
+    uint16_t size;
     uint8_t first_upper;
     uint8_t last_upper;
 } font_t;
 
-font_t fonts[] =
+// The font data stays in flash, switch_font() copies the selected font into RAM
+const font_t fonts[] =
 {
-    {fontdata_6847,     0x40,   0x5F},      // Default 6847 font
-    {fontdata_gime,     0x40,   0x5F},      // Gime Font from CoCo 3
-    {fontdata_6847t1,   0x40,   0x5F},      // 6847t1 font from CoCo2b
-    {fontdata_dalpha,   0x40,   0x7F},      // Dragon Alpha pmode 4 bootrom font 
-    {fontdata_BBC,      0X40,   0X5F},      // BBC Micro ROM font
-    {fontdata_CGA_thick,0x40,   0x7F},      // PC CGA, thick characters
-    {fontdata_CGA_thin, 0x40,   0x7F},      // PC CGA, thin characters
-    {fontdata_D200E,    0x40,   0x7F},      // Eurohard Dragon 200E 
-    {fontdata_saa5050,  0x40,   0x5F},      // SAA5050 teletext chip
-    {fontdata_spectrum, 0x40,   0x5F}       // Sinclair spectrum
+    {fontdata_6847,      sizeof(fontdata_6847),      0x40,   0x5F},      // Default 6847 font
+    {fontdata_gime,      sizeof(fontdata_gime),      0x40,   0x5F},      // Gime Font from CoCo 3
+    {fontdata_6847t1,    sizeof(fontdata_6847t1),    0x40,   0x5F},      // 6847t1 font from CoCo2b
+    {fontdata_dalpha,    sizeof(fontdata_dalpha),    0x40,   0x7F},      // Dragon Alpha pmode 4 bootrom font 
+    {fontdata_BBC,       sizeof(fontdata_BBC),       0X40,   0X5F},      // BBC Micro ROM font
+    {fontdata_CGA_thick, sizeof(fontdata_CGA_thick), 0x40,   0x7F},      // PC CGA, thick characters
+    {fontdata_CGA_thin,  sizeof(fontdata_CGA_thin),  0x40,   0x7F},      // PC CGA, thin characters
+    {fontdata_D200E,     sizeof(fontdata_D200E),     0x40,   0x7F},      // Eurohard Dragon 200E 
+    {fontdata_saa5050,   sizeof(fontdata_saa5050),   0x40,   0x5F},      // SAA5050 teletext chip
+    {fontdata_spectrum,  sizeof(fontdata_spectrum),  0x40,   0x5F}       // Sinclair spectrum
 };
 
 #define FONT_6847       0
@@ -0,0 +1,387 @@
+/*
+  host_sdk.c The parts of the Pico SDK and the bus interface (atom_if.c) that atomvga.c
+  uses, implemented for running the renderers on Linux. Anything that only matters to
+  the hardware does nothing.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "atom_if.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/scanvideo.h"
+#include "pico/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/interp.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/vreg.h"
+#include "hardware/watchdog.h"
+#include "host_sdk.h"
+
+// The 6502's view of memory, interleaved with the permissions as on the Pico
+volatile _Alignas(EB_BUFFER_SIZE) uint8_t _eb_memory[EB_BUFFER_SIZE * 2];
+
+void eb_init(PIO pio)
+{
+}
+
+void eb_shutdown()
+{
+}
+
+uint eb_get_event_chan()
+{
+    return 0;
+}
+
+// Bus events, a ring buffer the length of the event queue in atom_if.c
+#define HOST_EVENT_QUEUE_LEN 256
+static uint16_t event_queue[HOST_EVENT_QUEUE_LEN];
+static uint event_in = 0;
+static uint event_out = 0;
+
+bool host_queue_event(uint16_t address)
+{
+    uint next = (event_in + 1) % HOST_EVENT_QUEUE_LEN;
+    if (next == event_out)
+    {
+        return false;
+    }
+    event_queue[event_in] = address;
+    event_in = next;
+    return true;
+}
+
+int eb_get_event()
+{
+    if (event_out == event_in)
+    {
+        return -1;
+    }
+    int address = event_queue[event_out];
+    event_out = (event_out + 1) % HOST_EVENT_QUEUE_LEN;
+    return address;
+}
+
+// Timer
+
+static uint64_t start_ns;
+
+uint64_t time_us_64(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+    if (start_ns == 0)
+    {
+        start_ns = now;
+    }
+    return (now - start_ns) / 1000;
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, struct repeating_timer *out)
+{
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+bool cancel_repeating_timer(struct repeating_timer *timer)
+{
+    timer->callback = NULL;
+    return true;
+}
+
+// Clocks, power and stdio
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    return 250000000;
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required)
+{
+    return true;
+}
+
+void vreg_set_voltage(enum vreg_voltage voltage)
+{
+}
+
+void stdout_uart_init(void)
+{
+}
+
+// Cores and synchronisation, the host only ever runs core1's rendering
+
+void multicore_launch_core1(void (*entry)(void))
+{
+}
+
+uint get_core_num(void)
+{
+    return 1;
+}
+
+void sem_init(semaphore_t *sem, int16_t initial_permits, int16_t max_permits)
+{
+    sem->permits = initial_permits;
+}
+
+bool sem_release(semaphore_t *sem)
+{
+    sem->permits++;
+    return true;
+}
+
+void sem_acquire_blocking(semaphore_t *sem)
+{
+    sem->permits--;
+}
+
+static spin_lock_t spin_locks[32];
+
+int spin_lock_claim_unused(bool required)
+{
+    static int next_lock = 0;
+    return next_lock++;
+}
+
+spin_lock_t *spin_lock_init(uint lock_num)
+{
+    return &spin_locks[lock_num];
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock)
+{
+    return 0;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq)
+{
+}
+
+// Interrupts
+
+void irq_set_enabled(uint num, bool enabled)
+{
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+}
+
+// GPIO and PWM, the levels are kept for host_pwm_level()
+
+#define HOST_GPIO_COUNT 30
+static uint16_t gpio_levels[HOST_GPIO_COUNT];
+static uint16_t slice_tops[8];
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+}
+
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive)
+{
+}
+
+pwm_config pwm_get_default_config(void)
+{
+    pwm_config c = {0, 1 << 4, 0xffff};
+    return c;
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, float div)
+{
+}
+
+void pwm_config_set_phase_correct(pwm_config *c, bool phase_correct)
+{
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap)
+{
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start)
+{
+    slice_tops[slice_num] = c->top;
+}
+
+uint pwm_gpio_to_slice_num(uint gpio)
+{
+    return (gpio >> 1) & 7;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled)
+{
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level)
+{
+    gpio_levels[gpio] = level;
+}
+
+uint16_t host_pwm_level(unsigned gpio)
+{
+    return gpio_levels[gpio];
+}
+
+uint16_t host_pwm_top(unsigned gpio)
+{
+    return slice_tops[pwm_gpio_to_slice_num(gpio)];
+}
+
+// Watchdog
+
+static watchdog_hw_t watchdog;
+watchdog_hw_t *watchdog_hw = &watchdog;
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+}
+
+// PIO, only named by the bus interface
+
+PIO pio0 = NULL;
+PIO pio1 = NULL;
+
+// DMA, a transfer is a memcpy() done when the channel is triggered
+
+static dma_hw_t dma;
+dma_hw_t *dma_hw = &dma;
+
+typedef struct
+{
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint transfer_count;
+    uint size;
+} host_dma_channel_t;
+
+static host_dma_channel_t dma_channels[12];
+
+static void dma_channel_run(uint channel)
+{
+    host_dma_channel_t *ch = &dma_channels[channel];
+    memcpy((void *)ch->write_addr, (const void *)ch->read_addr, (size_t)ch->transfer_count << ch->size);
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    static int next_channel = 0;
+    return next_channel++;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c = {DMA_SIZE_32};
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    c->ctrl = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+}
+
+void channel_config_set_high_priority(dma_channel_config *c, bool high_priority)
+{
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    host_dma_channel_t *ch = &dma_channels[channel];
+    ch->write_addr = write_addr;
+    ch->read_addr = read_addr;
+    ch->transfer_count = transfer_count;
+    ch->size = config->ctrl;
+    if (trigger)
+    {
+        dma_channel_run(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger)
+{
+    dma_channels[channel].read_addr = read_addr;
+    if (trigger)
+    {
+        dma_channel_run(channel);
+    }
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger)
+{
+    dma_channels[channel].write_addr = write_addr;
+    if (trigger)
+    {
+        dma_channel_run(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    dma_channels[channel].transfer_count = trans_count;
+    if (trigger)
+    {
+        dma_channel_run(channel);
+    }
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return false;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+}
+
+// Interpolators, see hardware/interp.h
+
+interp_hw_t host_interp[2];
+
+// Scanvideo, host_video.c generates the scanlines itself
+
+const scanvideo_mode_t vga_mode_640x480_60 = {NULL, 640, 480, 1, 1};
+
+bool scanvideo_setup(const scanvideo_mode_t *mode)
+{
+    return true;
+}
+
+void scanvideo_timing_enable(bool enable)
+{
+}
+
+scanvideo_scanline_buffer_t *scanvideo_begin_scanline_generation(bool block)
+{
+    return NULL;
+}
+
+void scanvideo_end_scanline_generation(scanvideo_scanline_buffer_t *scanline_buffer)
+{
+}
@@ -0,0 +1,23 @@
+/*
+  host_sdk.h Hooks into the stand-in SDK in host_sdk.c, for driving the firmware the way
+  the hardware would.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief queue a 6502 bus event, as the event DMA channel does for each write
+/// @param address the 6502 address written
+/// @return false if the queue is full and the event was dropped
+bool host_queue_event(uint16_t address);
+
+/// @brief the level last set on a PWM pin
+/// @param gpio the pin
+/// @return the level, between 0 and the wrap of the pin's slice
+uint16_t host_pwm_level(unsigned gpio);
+
+/// @brief the wrap of a PWM pin's slice, see pwm_config_set_wrap()
+/// @param gpio the pin
+/// @return the highest level the pin counts to
+uint16_t host_pwm_top(unsigned gpio);
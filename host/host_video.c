@@ -0,0 +1,431 @@
+/*
+  host_video.c Builds atomvga.c for the host and drives its scanline renderers.
+
+  atomvga.c is compiled unchanged, with its main() renamed out of the way, against the
+  stand-in SDK headers in host/include and the functions in host_sdk.c.
+*/
+
+#include <time.h>
+
+#define main atomvga_main
+#include "atomvga.c"
+#undef main
+
+#include "host_sdk.h"
+#include "host_video.h"
+
+// Render a whole frame into here before decoding any of it, so the timing only covers
+// render_scanline()
+static uint32_t scanline_data[HOST_FRAME_HEIGHT][PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+
+void host_video_init(void)
+{
+    switch_font(DEFAULT_FONT);
+    initialize_vga80();
+    frame_lock = spin_lock_init(spin_lock_claim_unused(true));
+#if (FRAME_SNAPSHOT == 1)
+    snapshot_init();
+#endif
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Expand one scanline's composable tokens back to pixels. Anything scanvideo wouldn't
+// accept, or a line that doesn't fill the screen, stops the program.
+static void decode_scanline(uint line, const scanvideo_scanline_buffer_t *buffer, uint16_t *pixels)
+{
+    uint16_t row[HOST_FRAME_WIDTH + 16];
+    const uint16_t *p = (const uint16_t *)buffer->data;
+    const uint16_t *end = (const uint16_t *)(buffer->data + buffer->data_used);
+    uint x = 0;
+
+#define PIXEL(c)                                         \
+    do                                                   \
+    {                                                    \
+        if (x >= count_of(row))                          \
+        {                                                \
+            fprintf(stderr, "line %d too long\n", line); \
+            exit(1);                                     \
+        }                                                \
+        row[x++] = (c);                                  \
+    } while (0)
+
+    while (p < end)
+    {
+        uint16_t token = *p++;
+        if (token == COMPOSABLE_COLOR_RUN)
+        {
+            uint16_t colour = *p++;
+            uint count = *p++ + 3;
+            while (count--)
+            {
+                PIXEL(colour);
+            }
+        }
+        else if (token == COMPOSABLE_RAW_RUN)
+        {
+            PIXEL(*p++);
+            uint count = *p++ + 3 - 1;
+            while (count--)
+            {
+                PIXEL(*p++);
+            }
+        }
+        else if (token == COMPOSABLE_RAW_1P)
+        {
+            PIXEL(*p++);
+        }
+        else if (token == COMPOSABLE_RAW_2P)
+        {
+            PIXEL(*p++);
+            PIXEL(*p++);
+        }
+        else if (token == COMPOSABLE_EOL_ALIGN || token == COMPOSABLE_EOL_SKIP_ALIGN)
+        {
+            break;
+        }
+        else
+        {
+            fprintf(stderr, "line %d bad token %d\n", line, token);
+            exit(1);
+        }
+    }
+#undef PIXEL
+
+    if (x < HOST_FRAME_WIDTH)
+    {
+        fprintf(stderr, "line %d only %d pixels\n", line, x);
+        exit(1);
+    }
+    memcpy(pixels, row, HOST_FRAME_WIDTH * sizeof(uint16_t));
+}
+
+// There is no queue on the host, the beam is at the scanline being rendered
+static uint32_t beam_id;
+
+uint32_t scanvideo_get_next_scanline_id(void)
+{
+    return beam_id;
+}
+
+bool scanvideo_in_vblank(void)
+{
+    return false;
+}
+
+uint64_t host_render_frame_hook(host_frame_t *frame, host_line_hook_t hook, void *context)
+{
+    static uint frame_num = 0;
+    scanvideo_scanline_buffer_t buffers[HOST_FRAME_HEIGHT];
+
+    frame_num++;
+
+    // What core0 does when begin_frame() wakes it, done before the frame so commands
+    // written since the last one take effect in it
+    frame_started();
+    frame_tasks();
+    for (uint line = 0; line < HOST_FRAME_HEIGHT; line++)
+    {
+        buffers[line].scanline_id = (frame_num << 16) | line;
+        buffers[line].data = scanline_data[line];
+        buffers[line].data_used = 0;
+        buffers[line].data_max = PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS;
+        buffers[line].status = 0;
+    }
+
+    // The clock is only read around the hook, so without one only the loop is timed
+    uint64_t elapsed = 0;
+    uint64_t start = now_ns();
+    for (uint line = 0; line < HOST_FRAME_HEIGHT; line++)
+    {
+        if (hook)
+        {
+            elapsed += now_ns() - start;
+            hook(line, context);
+            start = now_ns();
+        }
+        beam_id = buffers[line].scanline_id;
+        render_scanline(&buffers[line]);
+    }
+    elapsed += now_ns() - start;
+
+    for (uint line = 0; line < HOST_FRAME_HEIGHT; line++)
+    {
+        decode_scanline(line, &buffers[line], frame->pixels[line]);
+    }
+    return elapsed;
+}
+
+uint64_t host_render_frame(host_frame_t *frame)
+{
+    return host_render_frame_hook(frame, NULL, NULL);
+}
+
+unsigned host_scanline_words(void)
+{
+    unsigned words = scanline_words_max;
+    scanline_words_max = 0;
+    return words;
+}
+
+uint32_t host_frame_hash(const host_frame_t *frame)
+{
+    const uint8_t *p = (const uint8_t *)frame->pixels;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(frame->pixels); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void host_frame_rgb(const host_frame_t *frame, uint8_t *rgb)
+{
+    for (uint y = 0; y < HOST_FRAME_HEIGHT; y++)
+    {
+        for (uint x = 0; x < HOST_FRAME_WIDTH; x++)
+        {
+            // Two bits each of red, green and blue, see RED, GREEN and BLUE in atomvga.h
+            uint16_t c = frame->pixels[y][x];
+            *rgb++ = ((c >> 10) & 3) * 85;
+            *rgb++ = ((c >> 12) & 3) * 85;
+            *rgb++ = ((c >> 14) & 3) * 85;
+        }
+    }
+}
+
+bool host_write_ppm(const char *path, const host_frame_t *frame)
+{
+    static uint8_t rgb[HOST_FRAME_HEIGHT * HOST_FRAME_WIDTH * 3];
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        return false;
+    }
+    host_frame_rgb(frame, rgb);
+    fprintf(f, "P6\n%d %d\n255\n", HOST_FRAME_WIDTH, HOST_FRAME_HEIGHT);
+    fwrite(rgb, 1, sizeof(rgb), f);
+    return fclose(f) == 0;
+}
+
+void host_set_font(unsigned font, bool lower)
+{
+    switch_font(font);
+    support_lower = lower;
+}
+
+unsigned host_font_count(void)
+{
+    return FONT_COUNT;
+}
+
+void host_set_artifact(unsigned art)
+{
+    artifact = art;
+}
+
+void host_set_scroll(unsigned start, unsigned fine, unsigned wrap)
+{
+    eb_set16(SCROLL_START, start);
+    eb_set(SCROLL_FINE, fine);
+    eb_set(SCROLL_WRAP, wrap);
+}
+
+void host_set_page(unsigned page)
+{
+    eb_set(PAGE_DISPLAY, page);
+}
+
+void host_set_copper(const uint16_t (*entries)[3], unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        eb_set16(COPPER_BASE + i * 4, entries[i][0]);
+        eb_set(COPPER_BASE + i * 4 + 2, entries[i][1]);
+        eb_set(COPPER_BASE + i * 4 + 3, entries[i][2]);
+    }
+    if (count < COPPER_LEN / 4)
+    {
+        eb_set16(COPPER_BASE + count * 4, 0xFFFF);
+    }
+    eb_set(COPPER_CTRL, count ? COPPER_ENABLE : 0);
+}
+
+void host_set_sprite(unsigned n, int x, int y, unsigned width, unsigned height, unsigned key, unsigned pattern)
+{
+    host_bus_write(SPRITE_SELECT, n);
+    while (!(eb_get(SPRITE_SELECT) & SPRITE_READY))
+    {
+    }
+    host_bus_write(SPRITE_X, x);
+    host_bus_write(SPRITE_X + 1, x >> 8);
+    host_bus_write(SPRITE_Y, y);
+    host_bus_write(SPRITE_Y + 1, y >> 8);
+    host_bus_write(SPRITE_WIDTH, width);
+    host_bus_write(SPRITE_HEIGHT, height);
+    host_bus_write(SPRITE_FLAGS, width ? SPRITE_ENABLE : 0);
+    host_bus_write(SPRITE_KEY, key);
+    host_bus_write(SPRITE_PATTERN, pattern);
+    host_bus_write(SPRITE_PATTERN + 1, pattern >> 8);
+}
+
+void host_blit(unsigned src, unsigned dst, unsigned width, unsigned height,
+               unsigned src_stride, unsigned dst_stride, unsigned op, unsigned value)
+{
+    host_bus_write(BLIT_SRC, src);
+    host_bus_write(BLIT_SRC + 1, src >> 8);
+    host_bus_write(BLIT_DST, dst);
+    host_bus_write(BLIT_DST + 1, dst >> 8);
+    host_bus_write(BLIT_WIDTH, width);
+    host_bus_write(BLIT_HEIGHT, height);
+    host_bus_write(BLIT_SRC_STRIDE, src_stride);
+    host_bus_write(BLIT_DST_STRIDE, dst_stride);
+    host_bus_write(BLIT_OP, op);
+    host_bus_write(BLIT_VALUE, value);
+    host_bus_write(BLIT_STATUS, BLIT_START);
+}
+
+// Write through the window, selecting bank | the bank of each offset as it is reached
+static void window_write(unsigned bank, unsigned offset, const uint8_t *data, unsigned len)
+{
+    for (unsigned i = 0; i < len; i++, offset++)
+    {
+        if (i == 0 || offset % EXT_WINDOW_SIZE == 0)
+        {
+            host_bus_write(EXT_BANK, bank | (offset / EXT_WINDOW_SIZE));
+            while (!(eb_get(EXT_BANK) & EXT_BANK_READY))
+            {
+            }
+        }
+        host_bus_write(EXT_WINDOW + offset % EXT_WINDOW_SIZE, data[i]);
+    }
+}
+
+void host_ext_write(unsigned offset, const uint8_t *data, unsigned len)
+{
+    window_write(0, offset, data, len);
+}
+
+void host_bitmap_write(unsigned offset, const uint8_t *data, unsigned len)
+{
+    window_write(EXT_BANK_BITMAP, offset, data, len);
+}
+
+void host_load_sprite_pattern(unsigned address, const uint8_t *data, unsigned len)
+{
+    window_write(EXT_BANK_SPRITES, address, data, len);
+}
+
+void host_set_ext_display(bool on)
+{
+    eb_set(EXT_CTRL, on ? EXT_DISPLAY : 0);
+}
+
+void host_set_palette(unsigned first, const uint8_t *colours, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        host_bus_write(PALETTE_BASE + first + i, colours[i]);
+    }
+}
+
+// Fill what there is room for in the ring and then move the head, as a 6502 program
+// would
+void host_draw(const uint8_t *commands, unsigned len)
+{
+    unsigned head = eb_get(DRAW_HEAD) % DRAW_RING_LEN;
+    unsigned i = 0;
+    while (i < len)
+    {
+        unsigned space = (eb_get(DRAW_TAIL) - head - 1 + DRAW_RING_LEN) % DRAW_RING_LEN;
+        for (; space > 0 && i < len; space--, i++)
+        {
+            host_bus_write(DRAW_RING + head, commands[i]);
+            head = (head + 1) % DRAW_RING_LEN;
+        }
+        host_bus_write(DRAW_HEAD, head);
+    }
+}
+
+void host_set_bitmap(bool on)
+{
+    eb_set(COL80_BASE, on ? COL80_BITMAP : COL80_OFF);
+}
+
+void host_set_vga80(bool on, bool attr)
+{
+    eb_set(COL80_BASE, on ? COL80_ON : COL80_OFF);
+    eb_set(COL80_FG, attr ? COL80_ATTR | 0x02 : 0x02);
+    eb_set(COL80_BG, 0x00);
+}
+
+void host_machine_init(void)
+{
+    eb_memset(0, 0, 0x10000);
+    eb_memset(GetVidMemBase(), VDG_SPACE, 0x200);
+    // The palette registers are in the memory cleared above, on the Pico core1_func()
+    // sets them after main() clears it
+    reset_palette();
+    set_bus_perms();
+    sc_init();
+}
+
+bool host_bus_write(uint16_t address, uint8_t data)
+{
+    if (!host_bus_store(address, data))
+    {
+        return false;
+    }
+    host_bus_handle();
+    return true;
+}
+
+bool host_bus_store(uint16_t address, uint8_t data)
+{
+    // The bus interface ignores writes to addresses with the not write enabled bit set
+    if (_eb_memory[address * 2 + 1] & 0b10)
+    {
+        return false;
+    }
+    eb_set(address, data);
+    host_queue_event(address);
+    return true;
+}
+
+void host_bus_handle(void)
+{
+    handler();
+
+    // What demo_loop() would do next, less the screen and SID dumps on the UART
+    vdu_updated();
+    sid_updated();
+    if (stats_selected())
+    {
+        update_stats_regs();
+    }
+    if (blit_started())
+    {
+        blit_run();
+    }
+    if (draw_pending())
+    {
+        draw_run();
+    }
+}
+
+unsigned host_audio_rate(void)
+{
+    return SC_SAMPLE_RATE;
+}
+
+int16_t host_audio_sample(void)
+{
+    sc_timer_callback(&sc_timer);
+    uint16_t top = host_pwm_top(SC_PIN);
+    return (int32_t)host_pwm_level(SC_PIN) * UINT16_MAX / (top ? top : 1) - 32768;
+}
@@ -0,0 +1,173 @@
+/*
+  host_video.h Runs the scanline renderers from atomvga.c on Linux, a frame at a time.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_FRAME_WIDTH 640
+#define HOST_FRAME_HEIGHT 480
+
+/// @brief a rendered frame, in the scanvideo pixel format the renderers use
+typedef struct
+{
+    uint16_t pixels[HOST_FRAME_HEIGHT][HOST_FRAME_WIDTH];
+} host_frame_t;
+
+/// @brief set up the renderers as core1_func() does before it starts the video
+void host_video_init(void);
+
+/// @brief render the next frame through render_scanline() and decode the scanlines
+/// @param frame where to put the pixels
+/// @return nanoseconds spent rendering, not counting the decoding
+uint64_t host_render_frame(host_frame_t *frame);
+
+/// @brief called before each scanline is rendered, see host_render_frame_hook()
+typedef void (*host_line_hook_t)(unsigned line, void *context);
+
+/// @brief render the next frame like host_render_frame(), calling a hook before each
+/// scanline so that bus writes can land part way through the frame
+/// @param frame where to put the pixels
+/// @param hook called with the scanline about to be rendered, or NULL
+/// @param context passed to the hook
+/// @return nanoseconds spent rendering, not counting the hook or the decoding
+uint64_t host_render_frame_hook(host_frame_t *frame, host_line_hook_t hook, void *context);
+
+/// @brief the most scanline buffer words any scanline has used, see print_stats()
+/// @return the high water mark, which is then reset
+unsigned host_scanline_words(void);
+
+/// @brief hash the pixels of a frame, for comparing against golden images
+/// @param frame the frame to hash
+/// @return 32 bit FNV-1a hash
+uint32_t host_frame_hash(const host_frame_t *frame);
+
+/// @brief convert a frame to 8 bit RGB
+/// @param frame the frame to convert
+/// @param rgb HOST_FRAME_WIDTH * HOST_FRAME_HEIGHT * 3 bytes, a row at a time
+void host_frame_rgb(const host_frame_t *frame, uint8_t *rgb);
+
+/// @brief write a frame as a binary PPM
+/// @param path file to write
+/// @param frame the frame to write
+/// @return true if the file was written
+bool host_write_ppm(const char *path, const host_frame_t *frame);
+
+/// @brief select a font and lower case support as the CHARSET and LOWER commands do
+/// @param font index into fonts[]
+/// @param lower true to enable lower case
+void host_set_font(unsigned font, bool lower);
+
+/// @brief the number of fonts in fonts[]
+unsigned host_font_count(void);
+
+/// @brief set the artifact mode as the ARTI command does
+/// @param art 0 for off, 1 or 2 for the two artifact palettes
+void host_set_artifact(unsigned art);
+
+/// @brief switch the 16 colour bitmap mode, see COL80_BITMAP
+/// @param on true to show the bitmap
+void host_set_bitmap(bool on);
+
+/// @brief switch 80 column mode, green on black
+/// @param on true for 80 columns
+/// @param attr true to take the colours from the attribute bytes
+void host_set_vga80(bool on, bool attr);
+
+/// @brief clear memory, set the bus permissions and start the sound engine, as main()
+/// and demo_loop() do before the 6502 bus interface is started
+void host_machine_init(void);
+
+/// @brief apply a 6502 write as the bus interface would and handle the bus event
+/// @param address the 6502 address
+/// @param data the byte written
+/// @return false if the address isn't writable and the write was ignored
+bool host_bus_write(uint16_t address, uint8_t data);
+
+/// @brief apply a 6502 write as the bus interface would, queuing its bus event to be
+/// handled later by host_bus_handle(), as when the interrupt is held off
+/// @param address the 6502 address
+/// @param data the byte written
+/// @return false if the address isn't writable and the write was ignored
+bool host_bus_store(uint16_t address, uint8_t data);
+
+/// @brief handle the queued bus events, then run what core0's main loop would
+void host_bus_handle(void);
+
+/// @brief the sound engine's sample rate
+unsigned host_audio_rate(void);
+
+/// @brief run the sound engine's timer callback once
+/// @return the PWM level it set, as a signed 16 bit sample
+int16_t host_audio_sample(void);
+
+/// @brief set the hardware scroll registers, see SCROLL_START in platform.h
+/// @param start offset in characters of the top left character
+/// @param fine scanlines of the top character row to skip
+/// @param wrap rows the screen wraps around in, 0 for the screen height
+void host_set_scroll(unsigned start, unsigned fine, unsigned wrap);
+
+/// @brief choose the page of video memory to display, see PAGE_DISPLAY in platform.h
+/// @param page offset from the start of video memory in 256 byte pages
+void host_set_page(unsigned page);
+
+/// @brief load and enable a copper display list, see COPPER_BASE in platform.h
+/// @param entries scanline, register and value of each entry
+/// @param count entries in the list, 0 turns the copper off
+void host_set_copper(const uint16_t (*entries)[3], unsigned count);
+
+/// @brief set up a sprite through its registers, see SPRITE_BASE in platform.h
+/// @param n sprite number
+/// @param x pixels from the left of the display area
+/// @param y pixels from the top of the display area
+/// @param width width in pixels, 0 turns the sprite off
+/// @param height height in pixels
+/// @param key colour number that is transparent
+/// @param pattern offset of the pattern in the pattern memory
+void host_set_sprite(unsigned n, int x, int y, unsigned width, unsigned height, unsigned key, unsigned pattern);
+
+/// @brief write sprite patterns through the bank window, see EXT_BANK_SPRITES in platform.h
+/// @param address pattern memory address of the first byte
+/// @param data colour numbers to load
+/// @param len bytes to load
+void host_load_sprite_pattern(unsigned address, const uint8_t *data, unsigned len);
+
+/// @brief run a blitter operation through its registers, see BLIT_BASE in platform.h
+/// @param src source address
+/// @param dst destination address
+/// @param width width in bytes
+/// @param height height in rows
+/// @param src_stride bytes from one source row to the next
+/// @param dst_stride bytes from one destination row to the next
+/// @param op operation and pixel size
+/// @param value fill byte or transparent colour
+void host_blit(unsigned src, unsigned dst, unsigned width, unsigned height,
+               unsigned src_stride, unsigned dst_stride, unsigned op, unsigned value);
+
+/// @brief write extended video memory through the bank window, see EXT_WINDOW in platform.h
+/// @param offset extended memory address of the first byte
+/// @param data bytes to write
+/// @param len number of bytes
+void host_ext_write(unsigned offset, const uint8_t *data, unsigned len);
+
+/// @brief display extended video memory instead of the 6502's, see EXT_CTRL in platform.h
+/// @param on true to display extended memory from PAGE_DISPLAY
+void host_set_ext_display(bool on);
+
+/// @brief write the bitmap through the bank window, see BITMAP_WIDTH in platform.h
+/// @param offset bitmap address of the first byte
+/// @param data bytes to write
+/// @param len number of bytes
+void host_bitmap_write(unsigned offset, const uint8_t *data, unsigned len);
+
+/// @brief write palette entries from first on, see PALETTE_BASE in platform.h
+/// @param first entry to start from
+/// @param colours high bytes of the scanvideo pixels
+/// @param count number of entries
+void host_set_palette(unsigned first, const uint8_t *colours, unsigned count);
+
+/// @brief send commands to the drawing engine, see DRAW_BASE in platform.h
+/// @param commands command and parameter bytes
+/// @param len number of bytes
+void host_draw(const uint8_t *commands, unsigned len);
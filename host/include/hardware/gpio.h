@@ -0,0 +1,25 @@
+#pragma once
+
+#include "pico.h"
+
+enum gpio_function
+{
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+};
+
+enum gpio_drive_strength
+{
+    GPIO_DRIVE_STRENGTH_2MA,
+    GPIO_DRIVE_STRENGTH_4MA,
+    GPIO_DRIVE_STRENGTH_8MA,
+    GPIO_DRIVE_STRENGTH_12MA,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
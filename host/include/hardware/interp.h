@@ -0,0 +1,76 @@
+// Host emulation of the RP2040 interpolators, just the parts the text renderers use:
+// shift, mask, cross input and base on lanes 0 and 1. The base and accumulator are as wide
+// as a pointer so the results can be dereferenced on a 64 bit host.
+#pragma once
+
+#include "pico.h"
+
+typedef struct
+{
+    uintptr_t accum[2];
+    uintptr_t base[3];
+    uint32_t ctrl[2];
+} interp_hw_t;
+
+extern interp_hw_t host_interp[2];
+
+#define interp0 (&host_interp[0])
+#define interp1 (&host_interp[1])
+
+#define INTERP_CTRL_SHIFT_BITS 0x0000001fu
+#define INTERP_CTRL_MASK_LSB_LSB 5
+#define INTERP_CTRL_MASK_MSB_LSB 10
+#define INTERP_CTRL_CROSS_INPUT_BITS 0x00010000u
+
+typedef struct
+{
+    uint32_t ctrl;
+} interp_config;
+
+static inline interp_config interp_default_config(void)
+{
+    interp_config c = {31u << INTERP_CTRL_MASK_MSB_LSB};
+    return c;
+}
+
+static inline void interp_config_set_shift(interp_config *c, uint shift)
+{
+    c->ctrl = (c->ctrl & ~INTERP_CTRL_SHIFT_BITS) | shift;
+}
+
+static inline void interp_config_set_mask(interp_config *c, uint mask_lsb, uint mask_msb)
+{
+    c->ctrl = (c->ctrl & ~(0x3ffu << INTERP_CTRL_MASK_LSB_LSB)) |
+              (mask_lsb << INTERP_CTRL_MASK_LSB_LSB) |
+              (mask_msb << INTERP_CTRL_MASK_MSB_LSB);
+}
+
+static inline void interp_config_set_cross_input(interp_config *c, bool cross_input)
+{
+    c->ctrl = (c->ctrl & ~INTERP_CTRL_CROSS_INPUT_BITS) | (cross_input ? INTERP_CTRL_CROSS_INPUT_BITS : 0);
+}
+
+static inline void interp_set_config(interp_hw_t *interp, uint lane, interp_config *config)
+{
+    interp->ctrl[lane] = config->ctrl;
+}
+
+static inline void interp_set_base(interp_hw_t *interp, uint lane, uintptr_t val)
+{
+    interp->base[lane] = val;
+}
+
+static inline void interp_set_accumulator(interp_hw_t *interp, uint lane, uintptr_t val)
+{
+    interp->accum[lane] = val;
+}
+
+static inline uintptr_t interp_peek_lane_result(interp_hw_t *interp, uint lane)
+{
+    uint32_t ctrl = interp->ctrl[lane];
+    uint lsb = (ctrl >> INTERP_CTRL_MASK_LSB_LSB) & 31;
+    uint msb = (ctrl >> INTERP_CTRL_MASK_MSB_LSB) & 31;
+    uint input = (ctrl & INTERP_CTRL_CROSS_INPUT_BITS) ? 1 - lane : lane;
+    uint32_t mask = ((msb == 31) ? 0xffffffffu : ((1u << (msb + 1)) - 1)) & ~((1u << lsb) - 1);
+    return interp->base[lane] + (((uint32_t)interp->accum[input] >> (ctrl & INTERP_CTRL_SHIFT_BITS)) & mask);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pico.h"
+
+// The bus interface isn't part of the host build, PIO instances are only named
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern PIO pio0;
+extern PIO pio1;
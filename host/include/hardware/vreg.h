@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pico.h"
+
+enum vreg_voltage
+{
+    VREG_VOLTAGE_1_25 = 0b1110,
+};
+
+void vreg_set_voltage(enum vreg_voltage voltage);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "pico.h"
+
+typedef struct
+{
+    uint32_t scratch[8];
+} watchdog_hw_t;
+
+extern watchdog_hw_t *watchdog_hw;
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
@@ -0,0 +1,44 @@
+// Host build stand-in for the Pico SDK's base header, enough of it to compile the
+// renderers on Linux. The hardware functions are implemented in host_sdk.c.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+#include <sys/types.h>
+
+typedef unsigned int uint;
+
+#define __not_in_flash_func(x) x
+#define __no_inline_not_in_flash_func(x) x
+#define __time_critical_func(x) x
+#define __scratch_x(n)
+#define __scratch_y(n)
+#define __in_flash(n)
+#define __not_in_flash(n)
+#define __force_inline inline __attribute__((always_inline))
+
+#define hard_assert(x) assert(x)
+
+#define __wfi()
+#define __wfe()
+#define __sev()
+#define __dmb()
+#define __compiler_memory_barrier() __asm__ volatile("" ::: "memory")
+
+static inline void tight_loop_contents(void) {}
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
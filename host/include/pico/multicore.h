@@ -0,0 +1,8 @@
+#pragma once
+
+#include "pico.h"
+
+void multicore_launch_core1(void (*entry)(void));
+
+// The host renders as core1
+uint get_core_num(void);
@@ -0,0 +1,59 @@
+// Host build stand-in for pico_extras' scanvideo. host_video.c hands scanline buffers to
+// render_scanline() itself, so the scanout side is all no-ops.
+#pragma once
+
+#include "pico.h"
+
+#ifndef PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT
+#define PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT 8
+#endif
+
+#ifndef PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS
+#define PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS 360
+#endif
+
+typedef struct scanvideo_timing
+{
+    uint32_t clock_freq;
+} scanvideo_timing_t;
+
+typedef struct scanvideo_mode
+{
+    const scanvideo_timing_t *default_timing;
+    uint16_t width;
+    uint16_t height;
+    uint8_t xscale;
+    uint16_t yscale;
+} scanvideo_mode_t;
+
+extern const scanvideo_mode_t vga_mode_640x480_60;
+
+#define SCANLINE_OK 1
+#define SCANLINE_ERROR 2
+#define SCANLINE_SKIPPED 3
+
+typedef struct scanvideo_scanline_buffer
+{
+    uint32_t scanline_id;
+    uint32_t *data;
+    uint16_t data_used;
+    uint16_t data_max;
+    uint8_t status;
+} scanvideo_scanline_buffer_t;
+
+static inline uint16_t scanvideo_scanline_number(uint32_t scanline_id)
+{
+    return (uint16_t)scanline_id;
+}
+
+static inline uint16_t scanvideo_frame_number(uint32_t scanline_id)
+{
+    return (uint16_t)(scanline_id >> 16u);
+}
+
+bool scanvideo_setup(const scanvideo_mode_t *mode);
+void scanvideo_timing_enable(bool enable);
+scanvideo_scanline_buffer_t *scanvideo_begin_scanline_generation(bool block);
+void scanvideo_end_scanline_generation(scanvideo_scanline_buffer_t *scanline_buffer);
+uint32_t scanvideo_get_next_scanline_id(void);
+bool scanvideo_in_vblank(void);
@@ -0,0 +1,13 @@
+#pragma once
+
+// Token values as in pico_extras, host_video.c decodes them back to pixels
+enum
+{
+    COMPOSABLE_COLOR_RUN = 0,
+    COMPOSABLE_EOL_ALIGN = 1,
+    COMPOSABLE_RAW_RUN = 2,
+    COMPOSABLE_RAW_1P = 3,
+    COMPOSABLE_RAW_2P = 4,
+    COMPOSABLE_EOL_SKIP_ALIGN = 5,
+    COMPOSABLE_RAW_1P_SKIP_ALIGN = 6,
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+void stdout_uart_init(void);
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
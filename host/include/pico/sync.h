@@ -0,0 +1,20 @@
+#pragma once
+
+#include "pico.h"
+
+typedef struct
+{
+    int permits;
+} semaphore_t;
+
+void sem_init(semaphore_t *sem, int16_t initial_permits, int16_t max_permits);
+bool sem_release(semaphore_t *sem);
+void sem_acquire_blocking(semaphore_t *sem);
+
+// The host is single threaded, so spin locks are never contended
+typedef volatile uint32_t spin_lock_t;
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_init(uint lock_num);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
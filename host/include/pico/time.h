@@ -0,0 +1,19 @@
+#pragma once
+
+#include "pico.h"
+
+struct repeating_timer
+{
+    int64_t delay_us;
+    bool (*callback)(struct repeating_timer *t);
+    void *user_data;
+};
+
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer *t);
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, struct repeating_timer *out);
+bool cancel_repeating_timer(struct repeating_timer *timer);
+
+// Microseconds since the host program started
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
@@ -0,0 +1,5 @@
+// Host build stand-in for the header pioasm generates from sm.pio. atom_if.c isn't part
+// of the host build, so only the names atom_if.h needs are here.
+#pragma once
+
+#include "hardware/pio.h"
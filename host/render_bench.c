@@ -0,0 +1,417 @@
+/*
+  render_bench.c Renders every display configuration on the host, times the renderers
+  and checks the frames against golden image hashes.
+
+  render_bench [-g golden.txt] [-u] [-p dir] [-n frames]
+
+    -g  golden hashes to check against, default golden.txt
+    -u  write the golden hashes from this run instead of checking them
+    -p  write each configuration's frame to dir as a PPM
+    -n  frames to render of each configuration for the timing, default 20
+
+  Returns non-zero if any frame doesn't match its golden hash or has none, only -u adds
+  new configurations to the golden hashes.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atom_if.h"
+#include "platform.h"
+#include "host_video.h"
+
+#define MAX_CONFIGS 256
+#define NAME_LEN 32
+
+typedef struct
+{
+    char name[NAME_LEN];
+    uint32_t hash;
+} golden_t;
+
+static golden_t golden[MAX_CONFIGS];
+static int golden_count = 0;
+
+static golden_t results[MAX_CONFIGS];
+static int result_count = 0;
+
+static host_frame_t frame;
+
+static int frames = 20;
+static const char *ppm_dir = NULL;
+static int failures = 0;
+static unsigned words_max = 0;
+
+static void load_golden(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return;
+    }
+    while (golden_count < MAX_CONFIGS &&
+           fscanf(f, "%31s %x", golden[golden_count].name, &golden[golden_count].hash) == 2)
+    {
+        golden_count++;
+    }
+    fclose(f);
+}
+
+static void save_golden(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror(path);
+        exit(1);
+    }
+    for (int i = 0; i < result_count; i++)
+    {
+        fprintf(f, "%s %08x\n", results[i].name, results[i].hash);
+    }
+    fclose(f);
+}
+
+static const golden_t *find_golden(const char *name)
+{
+    for (int i = 0; i < golden_count; i++)
+    {
+        if (!strcmp(golden[i].name, name))
+        {
+            return &golden[i];
+        }
+    }
+    return NULL;
+}
+
+// Render the configuration set up by the caller, report its time and check its frame
+static void run(const char *name)
+{
+    // The first frame latches the new state, so isn't timed
+    host_scanline_words();
+    host_render_frame(&frame);
+    uint64_t ns = 0;
+    for (int i = 0; i < frames; i++)
+    {
+        ns += host_render_frame(&frame);
+    }
+
+    uint32_t hash = host_frame_hash(&frame);
+    const golden_t *g = find_golden(name);
+    const char *status = !g ? "NEW" : (g->hash == hash) ? "ok" : "FAIL";
+    if (!g || g->hash != hash)
+    {
+        failures++;
+    }
+    unsigned words = host_scanline_words();
+    if (words > words_max)
+    {
+        words_max = words;
+    }
+    printf("%-24s %8.1f ns/line  %3u words  %08x  %s\n",
+           name, (double)ns / ((uint64_t)frames * HOST_FRAME_HEIGHT), words, hash, status);
+
+    if (ppm_dir)
+    {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s.ppm", ppm_dir, name);
+        if (!host_write_ppm(path, &frame))
+        {
+            perror(path);
+        }
+    }
+
+    if (result_count < MAX_CONFIGS)
+    {
+        strncpy(results[result_count].name, name, NAME_LEN - 1);
+        results[result_count].hash = hash;
+        result_count++;
+    }
+}
+
+// Fill the video window, including the 80 column attributes, with a fixed pseudo random
+// pattern so that every character, semigraphics block and pixel value turns up
+static void fill_video_memory()
+{
+    uint32_t seed = 1;
+    for (int i = 0; i < 80 * 40 * 2; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        eb_set(FB_ADDR + i, seed >> 16);
+    }
+}
+
+static void set_mode(unsigned mode, bool css)
+{
+    eb_set(PIA_ADDR, mode << 4);
+    eb_set(PIA_ADDR + 2, css ? 0x08 : 0x00);
+}
+
+int main(int argc, char **argv)
+{
+    const char *golden_path = "golden.txt";
+    bool update = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:up:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            golden_path = optarg;
+            break;
+        case 'u':
+            update = true;
+            break;
+        case 'p':
+            ppm_dir = optarg;
+            break;
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g golden.txt] [-u] [-p dir] [-n frames]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames < 1)
+    {
+        frames = 1;
+    }
+
+    host_video_init();
+    fill_video_memory();
+    if (!update)
+    {
+        load_golden(golden_path);
+    }
+
+    char name[NAME_LEN];
+
+    // Every 6847 mode in both colour sets, and the artifacted mode with both palettes
+    for (unsigned mode = 0; mode < 16; mode++)
+    {
+        for (int css = 0; css < 2; css++)
+        {
+            set_mode(mode, css);
+            snprintf(name, sizeof(name), "mode%X-css%d", mode, css);
+            run(name);
+        }
+    }
+    for (unsigned art = 1; art <= 2; art++)
+    {
+        for (int css = 0; css < 2; css++)
+        {
+            set_mode(0x0F, css);
+            host_set_artifact(art);
+            snprintf(name, sizeof(name), "mode%X-css%d-art%d", 0x0F, css, art);
+            run(name);
+        }
+    }
+    host_set_artifact(0);
+
+    // Every font in text mode, with and without lower case
+    set_mode(0, false);
+    for (unsigned font = 0; font < host_font_count(); font++)
+    {
+        for (int lower = 0; lower < 2; lower++)
+        {
+            host_set_font(font, lower);
+            snprintf(name, sizeof(name), "font%d-lower%d", font, lower);
+            run(name);
+        }
+    }
+
+    // 80 columns in every font, plain green on black and with attributes
+    host_set_font(0, false);
+    for (unsigned font = 0; font < host_font_count(); font++)
+    {
+        for (int attr = 0; attr < 2; attr++)
+        {
+            host_set_font(font, false);
+            host_set_vga80(true, attr);
+            snprintf(name, sizeof(name), "vga80-font%d-attr%d", font, attr);
+            run(name);
+        }
+    }
+    host_set_vga80(false, false);
+
+    // Hardware scroll, part way through a row so that the rows wrap part way across
+    for (int vga80 = 0; vga80 < 2; vga80++)
+    {
+        host_set_vga80(vga80, vga80);
+        host_set_scroll(vga80 ? 1000 : 100, 5, vga80 ? 30 : 12);
+        snprintf(name, sizeof(name), "scroll-vga80%d", vga80);
+        run(name);
+    }
+    host_set_scroll(0, 0, 0);
+    host_set_vga80(false, false);
+
+    // Displaying a later page of video memory, in text and a 3KB graphics mode
+    for (unsigned mode = 0; mode < 16; mode += 0xB)
+    {
+        set_mode(mode, false);
+        host_set_page(mode ? 12 : 3);
+        snprintf(name, sizeof(name), "page-mode%X", mode);
+        run(name);
+    }
+    host_set_page(0);
+    set_mode(0, false);
+
+    // A copper list: a text status bar with the second font part way down it between
+    // two graphics modes, then text in bands of paper colour
+    static const uint16_t copper[][3] = {
+        {120, COPPER_MODE, 0x0},
+        {120, COPPER_FONT, 1},
+        {168, COPPER_MODE, 0xB},
+        {168, COPPER_CSS, 1},
+        {360, COPPER_MODE, 0x0},
+        {360, COPPER_PAPER, 2},
+        {144, COPPER_FONT, 0},
+        {390, COPPER_PAPER, 3},
+    };
+    set_mode(0xD, false);
+    host_set_copper(copper, count_of(copper));
+    run("copper");
+    host_set_copper(NULL, 0);
+    set_mode(0, false);
+
+    // Sprites over text and graphics, overlapping each other and off the left and bottom
+    // edges, with colour 8 (black) transparent
+    uint8_t ball[12 * 12];
+    for (int i = 0; i < 12 * 12; i++)
+    {
+        int dx = i % 12 * 2 - 11;
+        int dy = i / 12 * 2 - 11;
+        ball[i] = (dx * dx + dy * dy < 100) ? 1 + (dx + dy + 22) / 12 : 8;
+    }
+    host_load_sprite_pattern(100, ball, sizeof(ball));
+    host_set_sprite(0, 40, 30, 12, 12, 8, 100);
+    host_set_sprite(1, 46, 36, 12, 12, 8, 100);
+    host_set_sprite(2, -5, 100, 12, 12, 8, 100);
+    host_set_sprite(7, 200, 185, 12, 12, 8, 100);
+    for (unsigned mode = 0; mode < 16; mode += 0xF)
+    {
+        set_mode(mode, false);
+        snprintf(name, sizeof(name), "sprites-mode%X", mode);
+        run(name);
+    }
+    for (unsigned n = 0; n < 8; n++)
+    {
+        host_set_sprite(n, 0, 0, 0, 0, 0, 0);
+    }
+    set_mode(0, false);
+
+    // The blitter in a colour graphics mode: a filled box, an overlapping copy of part
+    // of the screen and a copy through a transparent colour. This changes video memory
+    // so it comes last.
+    set_mode(0xD, false);
+    host_blit(0, FB_ADDR + 32 * 8 + 4, 8, 40, 0, 32, BLIT_FILL, 0xE4);
+    host_blit(FB_ADDR + 32 * 60, FB_ADDR + 32 * 62 + 2, 16, 40, 32, 32, BLIT_COPY, 0);
+    host_blit(FB_ADDR + 32 * 8 + 4, FB_ADDR + 32 * 30 + 20, 8, 40, 32, 32, BLIT_KEY | BLIT_KEY_2BPP, 1);
+    run("blit-modeD");
+    fill_video_memory();
+
+    // Every drawing command in a colour and a two colour mode
+    static const uint8_t drawing[] = {
+        DRAW_COLOUR, 0, DRAW_CLEAR,
+        DRAW_COLOUR, 1, DRAW_LINE, 0, 0, 127, 191,
+        DRAW_COLOUR, 2, DRAW_CIRCLE, 64, 96, 40,
+        DRAW_COLOUR, 3, DRAW_DISC, 100, 40, 20,
+        DRAW_COLOUR, 1, DRAW_TRIANGLE, 10, 150, 60, 120, 40, 185,
+        DRAW_COLOUR, 2, DRAW_BOX, 70, 130, 120, 180,
+        DRAW_COLOUR, 3, DRAW_POLYGON, 5, 10, 10, 50, 20, 30, 30, 50, 60, 5, 50,
+        DRAW_COLOUR, 1, DRAW_RECT, 80, 140, 100, 150,
+        DRAW_POINT, 64, 100,
+        DRAW_COLOUR, 2, DRAW_FLOOD, 100, 40,
+    };
+    for (unsigned mode = 0xD; mode < 16; mode += 2)
+    {
+        set_mode(mode, false);
+        host_draw(drawing, sizeof(drawing));
+        snprintf(name, sizeof(name), "draw-mode%X", mode);
+        run(name);
+    }
+    set_mode(0, false);
+    fill_video_memory();
+
+    // 80x40 with attributes displayed from extended memory, written through the window
+    static uint8_t ext[80 * 40 * 2];
+    for (int i = 0; i < 80 * 40; i++)
+    {
+        ext[i] = i;
+        ext[80 * 40 + i] = i / 80 * 7;
+    }
+    host_ext_write(0x1000, ext, sizeof(ext));
+    host_set_vga80(true, true);
+    host_set_page(0x10);
+    host_set_ext_display(true);
+    run("ext-vga80-attr");
+    host_set_ext_display(false);
+    host_set_page(0);
+    host_set_vga80(false, false);
+
+    // Every colour of the bitmap, with a one pixel wide diagonal to show the pixel order
+    static uint8_t bitmap[BITMAP_SIZE];
+    for (int y = 0; y < BITMAP_HEIGHT; y++)
+    {
+        for (int x = 0; x < BITMAP_WIDTH; x++)
+        {
+            unsigned colour = (x == y) ? 15 : ((x / 16) ^ (y / 48)) & 15;
+            uint8_t *b = &bitmap[(y * BITMAP_WIDTH + x) / 2];
+            *b = (x & 1) ? (*b & 0xF0) | colour : (*b & 0x0F) | (colour << 4);
+        }
+    }
+    host_bitmap_write(0, bitmap, sizeof(bitmap));
+    host_set_bitmap(true);
+    run("bitmap");
+
+    // A grey ramp in every palette entry, then a changed 80 column background, keeping
+    // the colours read back from the registers to put back afterwards
+    uint8_t saved[PALETTE_ENTRIES], palette[PALETTE_ENTRIES];
+    for (unsigned i = 0; i < PALETTE_ENTRIES; i++)
+    {
+        saved[i] = eb_get(PALETTE_BASE + i);
+        palette[i] = (i / 4) * 0x54;
+    }
+    host_set_palette(0, palette, PALETTE_ENTRIES);
+    run("palette-bitmap");
+    host_set_bitmap(false);
+    host_set_vga80(true, true);
+    run("palette-vga80-attr");
+    palette[0] = 0x40; // dark blue
+    host_set_palette(0, palette, 1);
+    run("palette-vga80-bg");
+    host_set_vga80(false, false);
+
+    // The grey ramp through the 6847 colours: a colour graphics mode, the artifact
+    // colours and the text ink
+    set_mode(0xD, false);
+    run("palette-modeD");
+    set_mode(0xF, false);
+    host_set_artifact(1);
+    run("palette-artifact");
+    host_set_artifact(0);
+    set_mode(0, false);
+    run("palette-text");
+    host_set_palette(0, saved, PALETTE_ENTRIES);
+
+    printf("most scanline buffer words %u of %d\n", words_max, PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS);
+
+    if (update)
+    {
+        save_golden(golden_path);
+        printf("wrote %d golden hashes to %s\n", result_count, golden_path);
+        return 0;
+    }
+    if (failures)
+    {
+        printf("%d of %d frames differ from or are missing from %s, -u rewrites it\n",
+               failures, result_count, golden_path);
+        return 1;
+    }
+    return 0;
+}
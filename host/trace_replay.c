@@ -0,0 +1,313 @@
+/*
+  trace_replay.c Replays a recorded trace of 6502 bus writes through the firmware on the
+  host, writing out the frames it displays and the sound it plays.
+
+  trace_replay [-p dir] [-y video.y4m] [-w audio.wav] [-n frames] [-c hash] trace.txt
+
+    -p  write each frame to dir as a PPM
+    -y  write the frames as a YUV4MPEG2 (4:4:4) video
+    -w  write the sound as a 16 bit mono WAV
+    -n  frames to render, default until one frame after the last write
+    -c  return non-zero unless the last frame has this hash
+
+  The trace is text, one write per line: the time in microseconds from the start of
+  the first frame, then the address and the data in hex, for example
+
+    16683 BDE0 80
+
+  Blank lines and anything after a # are ignored, the times must not go backwards.
+  Writes with the same time all land before the bus event handler runs for them, as
+  when its interrupt is held off.
+
+  Writes are applied in time order between the scanlines, with a 640x480 scanline every
+  31.778us and 525 to a frame as scanvideo does, and the sound engine's timer runs at
+  its sample rate in between, so the output is the same every run. A line is printed for
+  each frame with its hash and the render time.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "host_video.h"
+
+// 640x480 at 59.94Hz, 800 pixels of 25.175MHz a line
+#define LINE_NS 31778
+#define FRAME_LINES 525
+#define FRAME_NS ((uint64_t)LINE_NS * FRAME_LINES)
+
+typedef struct
+{
+    uint64_t time_ns;
+    uint16_t address;
+    uint8_t data;
+} trace_write_t;
+
+static trace_write_t *trace;
+static size_t trace_len = 0;
+static size_t trace_next = 0;
+static uint32_t writes_ignored = 0;
+
+static uint64_t sample_ns;
+static uint64_t next_sample_ns = 0;
+static FILE *wav = NULL;
+static uint32_t wav_samples = 0;
+
+static host_frame_t frame;
+
+static void load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        exit(1);
+    }
+    size_t size = 1024;
+    trace = malloc(size * sizeof(trace_write_t));
+    char text[256];
+    int line = 0;
+    uint64_t last_us = 0;
+    while (fgets(text, sizeof(text), f))
+    {
+        line++;
+        char *comment = strchr(text, '#');
+        if (comment)
+        {
+            *comment = 0;
+        }
+        unsigned long long time_us;
+        unsigned address, data;
+        char extra;
+        int fields = sscanf(text, "%llu %x %x %c", &time_us, &address, &data, &extra);
+        if (fields <= 0)
+        {
+            continue;
+        }
+        if (fields != 3 || address > 0xFFFF || data > 0xFF || time_us < last_us)
+        {
+            fprintf(stderr, "%s:%d: expected increasing time, address and data\n", path, line);
+            exit(1);
+        }
+        if (trace_len == size)
+        {
+            size *= 2;
+            trace = realloc(trace, size * sizeof(trace_write_t));
+        }
+        trace[trace_len].time_ns = time_us * 1000;
+        trace[trace_len].address = address;
+        trace[trace_len].data = data;
+        trace_len++;
+        last_us = time_us;
+    }
+    fclose(f);
+}
+
+static void put_le(FILE *f, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        fputc(value >> (i * 8), f);
+    }
+}
+
+// The sizes in the header are filled in by wav_close()
+static void wav_header(FILE *f, uint32_t samples)
+{
+    uint32_t rate = host_audio_rate();
+    fwrite("RIFF", 1, 4, f);
+    put_le(f, 36 + samples * 2, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_le(f, 16, 4);       // format chunk size
+    put_le(f, 1, 2);        // PCM
+    put_le(f, 1, 2);        // mono
+    put_le(f, rate, 4);
+    put_le(f, rate * 2, 4); // bytes per second
+    put_le(f, 2, 2);        // bytes per sample
+    put_le(f, 16, 2);       // bits per sample
+    fwrite("data", 1, 4, f);
+    put_le(f, samples * 2, 4);
+}
+
+static void wav_close()
+{
+    fseek(wav, 0, SEEK_SET);
+    wav_header(wav, wav_samples);
+    fclose(wav);
+}
+
+// Apply the writes and run the sound engine up to a time, in time order
+static void run_until(uint64_t time_ns)
+{
+    for (;;)
+    {
+        uint64_t write_ns = (trace_next < trace_len) ? trace[trace_next].time_ns : UINT64_MAX;
+        if (next_sample_ns <= write_ns && next_sample_ns < time_ns)
+        {
+            int16_t sample = host_audio_sample();
+            if (wav)
+            {
+                put_le(wav, (uint16_t)sample, 2);
+                wav_samples++;
+            }
+            next_sample_ns += sample_ns;
+        }
+        else if (write_ns < time_ns)
+        {
+            while (trace_next < trace_len && trace[trace_next].time_ns == write_ns)
+            {
+                if (!host_bus_store(trace[trace_next].address, trace[trace_next].data))
+                {
+                    writes_ignored++;
+                }
+                trace_next++;
+            }
+            host_bus_handle();
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+static void before_line(unsigned line, void *context)
+{
+    run_until(*(uint64_t *)context + (uint64_t)line * LINE_NS);
+}
+
+// BT.601 studio range
+static void write_y4m_frame(FILE *f)
+{
+    static uint8_t rgb[HOST_FRAME_HEIGHT * HOST_FRAME_WIDTH * 3];
+    static uint8_t planes[3][HOST_FRAME_HEIGHT * HOST_FRAME_WIDTH];
+    host_frame_rgb(&frame, rgb);
+    for (size_t i = 0; i < HOST_FRAME_HEIGHT * HOST_FRAME_WIDTH; i++)
+    {
+        int r = rgb[i * 3];
+        int g = rgb[i * 3 + 1];
+        int b = rgb[i * 3 + 2];
+        planes[0][i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+        planes[1][i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+        planes[2][i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    }
+    fputs("FRAME\n", f);
+    fwrite(planes, 1, sizeof(planes), f);
+}
+
+int main(int argc, char **argv)
+{
+    const char *ppm_dir = NULL;
+    const char *y4m_path = NULL;
+    const char *wav_path = NULL;
+    long frames = -1;
+    const char *check = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:y:w:n:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            ppm_dir = optarg;
+            break;
+        case 'y':
+            y4m_path = optarg;
+            break;
+        case 'w':
+            wav_path = optarg;
+            break;
+        case 'n':
+            frames = atol(optarg);
+            break;
+        case 'c':
+            check = optarg;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-p dir] [-y video.y4m] [-w audio.wav] [-n frames] [-c hash] trace.txt\n", argv[0]);
+        return 2;
+    }
+
+    load_trace(argv[optind]);
+    if (frames < 0)
+    {
+        frames = (trace_len ? trace[trace_len - 1].time_ns / FRAME_NS : 0) + 2;
+    }
+
+    FILE *y4m = NULL;
+    if (y4m_path)
+    {
+        y4m = fopen(y4m_path, "wb");
+        if (!y4m)
+        {
+            perror(y4m_path);
+            return 1;
+        }
+        fprintf(y4m, "YUV4MPEG2 W%d H%d F60000:1001 Ip A1:1 C444\n", HOST_FRAME_WIDTH, HOST_FRAME_HEIGHT);
+    }
+    if (wav_path)
+    {
+        wav = fopen(wav_path, "wb");
+        if (!wav)
+        {
+            perror(wav_path);
+            return 1;
+        }
+        wav_header(wav, 0);
+    }
+
+    host_video_init();
+    host_machine_init();
+    sample_ns = 1000000000u / host_audio_rate();
+
+    uint64_t total_ns = 0;
+    for (long n = 0; n < frames; n++)
+    {
+        uint64_t frame_start = n * FRAME_NS;
+        uint64_t ns = host_render_frame_hook(&frame, before_line, &frame_start);
+        run_until(frame_start + FRAME_NS);
+        total_ns += ns;
+
+        printf("frame %5ld  %08x  %8.1f ns/line  %zu writes\n",
+               n, host_frame_hash(&frame), (double)ns / HOST_FRAME_HEIGHT, trace_next);
+        if (ppm_dir)
+        {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/frame%05ld.ppm", ppm_dir, n);
+            if (!host_write_ppm(path, &frame))
+            {
+                perror(path);
+                return 1;
+            }
+        }
+        if (y4m)
+        {
+            write_y4m_frame(y4m);
+        }
+    }
+
+    if (y4m)
+    {
+        fclose(y4m);
+    }
+    if (wav)
+    {
+        wav_close();
+    }
+    printf("%ld frames, %zu of %zu writes replayed, %lu ignored, %.1f ns/line\n",
+           frames, trace_next, trace_len, (unsigned long)writes_ignored,
+           frames ? (double)total_ns / ((uint64_t)frames * HOST_FRAME_HEIGHT) : 0.0);
+    if (check && strtoul(check, NULL, 16) != host_frame_hash(&frame))
+    {
+        printf("last frame %08x, expected %s\n", host_frame_hash(&frame), check);
+        return 1;
+    }
+    return 0;
+}
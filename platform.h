@@ -29,6 +29,42 @@
 #define COL80_STAT  0xBDEF
 #define COL80_MASK  0xFFF0
 
+// Hardware scroll, in the spare 80 column registers
+#define SCROLL_BASE 0xBDE6
+
+// Page flipping
+#define PAGE_BASE   0xBDEA
+
+// Raster status, above the 80 column registers
+#define RASTER_BASE 0xBDF0
+
+// Copper display list, its control register is a spare 80 column register
+#define COPPER_BASE 0xBD40
+#define COPPER_LEN  128
+#define COPPER_CTRL 0xBDE1
+
+// Sprites, below the copper list
+#define SPRITE_BASE 0xBD30
+
+// Blitter, above the raster status
+#define BLIT_BASE   0xBDF5
+
+// Drawing engine, in the spare 80 column registers, and its command ring below the
+// extended memory window
+#define DRAW_BASE   0xBDE2
+#define DRAW_RING   0x9B00
+
+// Extended video memory, the window is above the 80x40 attribute mode's attributes
+#define EXT_WINDOW  0x9C00
+#define EXT_BANK    0xBDEC
+#define EXT_CTRL    0xBDED
+
+// Palette, at the top of the drawing engine's page
+#define PALETTE_BASE 0x9BF0
+
+// Render statistics, below the SID at 0xBDC0
+#define STATS_BASE  0xBD00
+
 // Macros to get VDU memory base
 #define GetVidMemBase() FB_ADDR
 #define GetVidMemEnd()  (FB_ADDR+VID_MEM_SIZE)
@@ -81,6 +117,12 @@
 #define COL80_STAT  0xFF8B
 #define COL80_MASK  0xFFF8
 
+// Hardware scroll, in the spare 80 column registers
+#define SCROLL_BASE 0xFF8C
+
+// Render statistics
+#define STATS_BASE  0xFF90
+
 volatile uint16_t    SAMBits;
 
 #define SAM_BASE        0xFFC0
@@ -128,6 +170,33 @@ volatile uint16_t    SAMBits;
 #define DRAGON_PAPER_ADDR   0xFF83
 #define DRAGON_INKALT_ADDR  0xFF84
 
+// Page flipping
+#define PAGE_BASE   0xFF85
+
+// Raster status, below the command registers
+#define RASTER_BASE 0xFF7B
+
+// Copper display list, only room for 6 entries
+#define COPPER_BASE 0xFF60
+#define COPPER_LEN  24
+#define COPPER_CTRL 0xFF87
+
+// Sprites and the blitter, in the disk controller's space so not with DragonDOS
+#define SPRITE_BASE 0xFF40
+#define BLIT_BASE   0xFF50
+
+// Drawing engine, and its command ring below the extended memory window
+#define DRAW_BASE   0xFF78
+#define DRAW_RING   0xDB00
+
+// Extended video memory, the window is in the cartridge space
+#define EXT_WINDOW  0xDC00
+#define EXT_BANK    0xFF5B
+#define EXT_CTRL    0xFF5C
+
+// Palette, at the top of the drawing engine's page
+#define PALETTE_BASE 0xDBF0
+
 #define DRAGON_CMD_NONE     0x00
 #define DRAGON_CMD_DEBUG    0x01
 #define DRAGON_CMD_NODEBUG  0x02
@@ -140,6 +209,8 @@ volatile uint16_t    SAMBits;
 #define DRAGON_CMD_LOADEE   0x09
 #define DRAGON_CMD_AUTOOFF  0x0A
 #define DRAGON_CMD_AUTOON   0x0B
+#define DRAGON_CMD_PERF     0x0C
+#define DRAGON_CMD_NOPERF   0x0D
 
 #define LOWER_START   0x00
 #define LOWER_END     0x40
@@ -164,5 +235,254 @@ volatile uint16_t    SAMBits;
 #define VDG_SPACE     96
 #endif
 
+// Hardware scroll registers, for the 32 column text and semigraphics modes and 80 columns
+//  +0..1   start address, the offset in characters from the start of video memory of the
+//          top left character
+//  +2      fine scroll, scanlines of the top character row to skip, 0-11
+//  +3      wrap, rows of video memory the screen wraps around in, 0 for the height of the
+//          screen (16 rows of 32 or 40 of 80). The 80 column attributes wrap with the
+//          characters, 80 * 40 bytes after them.
+// Multi-byte values are little endian. All zero is the unscrolled screen.
+#define SCROLL_LEN      4
+#define SCROLL_START    SCROLL_BASE
+#define SCROLL_FINE     (SCROLL_BASE + 2)
+#define SCROLL_WRAP     (SCROLL_BASE + 3)
+
+// Page flipping registers. A page is 256 bytes of video memory, the display can start
+// at any page of the video memory so the 6502 can draw into one part of it while
+// another is displayed.
+//  +0      page to display from the start of video memory, taken at the start of the
+//          next frame. It is limited to the last page that leaves the whole screen of
+//          the mode inside the 6400 bytes of video memory the Pico keeps.
+//  +1      page being displayed, read only. It changes to the requested page at the
+//          start of the frame that shows it, from then the old page can be drawn into.
+#define PAGE_LEN        2
+#define PAGE_DISPLAY    PAGE_BASE
+#define PAGE_SHOWN      (PAGE_BASE + 1)
+
+// Raster status registers, read only, updated by the renderer as each scanline is sent
+//  +0..1   VGA scanline being displayed, 0-479, reads 480 during the vertical blank
+//  +2      status, bit 7 set during the vertical blank so BIT / BMI can test it
+//  +3..4   frame counter, counts up at the start of each vertical blank
+// Multi-byte values are little endian and can change between reading their bytes, read
+// them twice and compare when that matters. The line is only updated when scanvideo
+// frees a scanline buffer, so it is accurate to a line while the display is active.
+#define RASTER_LEN      5
+#define RASTER_LINE     RASTER_BASE
+#define RASTER_STATUS   (RASTER_BASE + 2)
+#define RASTER_FRAME    (RASTER_BASE + 3)
+
+#define RASTER_VBLANK   0x80
+
+// Copper display list, register changes the renderer makes part way down the screen.
+// COPPER_LEN / 4 entries of
+//  +0..1   VGA scanline the change takes effect from, 0-479, 0xFFFF ends the list
+//  +2      register to change, see COPPER_MODE
+//  +3      value
+// Multi-byte values are little endian. The list is taken at the start of each frame when
+// bit 7 of COPPER_CTRL is set, so it can be written with the bit clear and then
+// enabled. Entries need not be in order, those for the same scanline are applied in
+// list order. Each frame starts from the registers the 6502 last wrote.
+#define COPPER_ENABLE   0x80
+
+#define COPPER_MODE     0x00    // VDG mode, see get_mode()
+#define COPPER_CSS      0x01    // colour set select, 0 or 1
+#define COPPER_COL80    0x02    // as COL80_BASE
+#define COPPER_FG       0x03    // as COL80_FG
+#define COPPER_BG       0x04    // as COL80_BG
+#define COPPER_INK      0x05    // colour number, as the FG command
+#define COPPER_PAPER    0x06    // colour number, as the BG command
+#define COPPER_INK_ALT  0x07    // colour number, as the FGA command
+#define COPPER_SCROLL_L 0x08    // low byte of SCROLL_START
+#define COPPER_SCROLL_H 0x09    // high byte of SCROLL_START
+#define COPPER_FINE     0x0A    // as SCROLL_FINE
+#define COPPER_FONT     0x0B    // font number, only one font other than the selected one
+                                // can be used in a frame
+#define COPPER_REGS     0x0C
+
+// Sprite registers. Sprites are drawn over the 256x192 display area of the 6847 modes,
+// or the same area of the 80 column mode, each sprite pixel two VGA pixels square.
+// Sprite 0 is in front. The patterns are one byte a pixel, a colour number as the FG
+// command takes, in SPRITE_PATTERN_SIZE bytes of Pico memory written through the
+// extended memory window, selecting bank n of it with EXT_BANK_SPRITES | n.
+//  +0      sprite whose registers are at +1 to +10, in bits 0-2. Selecting a sprite
+//          fills +1 to +10 with its registers and then sets SPRITE_READY, wait for it
+//          before reading or writing them or selecting another sprite
+//  +1..2   x, pixels from the left of the display area, signed
+//  +3..4   y, pixels from the top of the display area, signed
+//  +5      width in pixels, up to SPRITE_MAX_WIDTH
+//  +6      height in pixels
+//  +7      flags, see SPRITE_ENABLE
+//  +8      colour number of the pattern that is transparent
+//  +9..10  offset of the pattern in the pattern memory, rows of width bytes
+//  +11..13 unused
+//  +14     collisions, read only, a bit for each sprite that overlapped another sprite
+//          in the last frame
+// Multi-byte values are little endian. The sprites are taken at the start of each frame.
+#define SPRITE_LEN      16
+#define SPRITE_SELECT   SPRITE_BASE
+#define SPRITE_X        (SPRITE_BASE + 1)
+#define SPRITE_Y        (SPRITE_BASE + 3)
+#define SPRITE_WIDTH    (SPRITE_BASE + 5)
+#define SPRITE_HEIGHT   (SPRITE_BASE + 6)
+#define SPRITE_FLAGS    (SPRITE_BASE + 7)
+#define SPRITE_KEY      (SPRITE_BASE + 8)
+#define SPRITE_PATTERN  (SPRITE_BASE + 9)
+#define SPRITE_HITS     (SPRITE_BASE + 14)
+
+#define SPRITE_REGS     10      // registers of the selected sprite, +1 to +10
+#define SPRITE_READY    0x80    // in SPRITE_SELECT
+#define SPRITE_ENABLE   0x80    // in SPRITE_FLAGS
+
+#define SPRITE_COUNT        8
+#define SPRITE_MAX_WIDTH    32
+#define SPRITE_PATTERN_SIZE 4096
+
+// Blitter registers, for copying and filling rectangles of video memory. A rectangle is
+// height rows of width bytes, each row stride bytes after the one before, so it can
+// be pixels of a graphics mode or characters or attributes of a text mode. Bytes
+// outside video memory are left alone.
+//  +0..1   source address
+//  +2..3   destination address
+//  +4      width in bytes
+//  +5      height in rows
+//  +6      source stride
+//  +7      destination stride
+//  +8      operation, see BLIT_COPY, and for BLIT_KEY the pixel size
+//  +9      fill byte for BLIT_FILL, transparent colour for BLIT_KEY
+//  +10     write BLIT_START to start, bit 7 reads as set until the operation is done
+// Multi-byte values are little endian. Overlapping copies work either way. The 6502
+// reads its own copy of video memory unless the firmware is built with
+// SERVE_VIDEO_RAM, so without that it can't see what the blitter wrote.
+#define BLIT_LEN        11
+#define BLIT_SRC        BLIT_BASE
+#define BLIT_DST        (BLIT_BASE + 2)
+#define BLIT_WIDTH      (BLIT_BASE + 4)
+#define BLIT_HEIGHT     (BLIT_BASE + 5)
+#define BLIT_SRC_STRIDE (BLIT_BASE + 6)
+#define BLIT_DST_STRIDE (BLIT_BASE + 7)
+#define BLIT_OP         (BLIT_BASE + 8)
+#define BLIT_VALUE      (BLIT_BASE + 9)
+#define BLIT_STATUS     (BLIT_BASE + 10)
+
+#define BLIT_COPY       0x00    // destination = source
+#define BLIT_FILL       0x01    // destination = value
+#define BLIT_OR         0x02    // destination |= source
+#define BLIT_AND        0x03    // destination &= source
+#define BLIT_XOR        0x04    // destination ^= source
+#define BLIT_KEY        0x05    // source pixels not of the value's colour are copied
+#define BLIT_OP_MASK    0x07
+
+#define BLIT_KEY_BYTE   0x00    // BLIT_KEY pixel size, bytes for the text modes
+#define BLIT_KEY_2BPP   0x10    // 2 bit pixels, the colour graphics modes
+#define BLIT_KEY_1BPP   0x20    // 1 bit pixels, the two colour graphics modes
+#define BLIT_KEY_MASK   0x30
+
+#define BLIT_START      0x80
+
+// Drawing engine registers, which draw into video memory in the current graphics mode
+//  +0      DRAW_HEAD, where the 6502 will put the next byte in DRAW_RING
+//  +1      status, see DRAW_BUSY. Writing it drops the bytes up to DRAW_HEAD and clears
+//          the status.
+// Commands are queued in a ring of DRAW_RING_LEN bytes at DRAW_RING, followed by
+// DRAW_TAIL, the next byte the Pico will draw. Write the bytes from DRAW_HEAD on, then
+// write DRAW_HEAD past them, after one byte or many. The ring is full when DRAW_HEAD is
+// one byte behind DRAW_TAIL, and it is empty and drawn when they are equal and
+// DRAW_BUSY is clear. After writing the status, wait until DRAW_TAIL catches up with
+// DRAW_HEAD before queuing more.
+// A command is a byte from DRAW_COLOUR on followed by its parameters. Coordinates are
+// a byte each, pixels of the graphics mode from the top left, and anything off the
+// screen is clipped. Colours are pixel values, 0-3 in the colour modes and 0-1 in the
+// others. Nothing is drawn in the text modes. Drawing goes into page 0 of video memory
+// unless DRAW_PAGE says otherwise, see PAGE_DISPLAY.
+#define DRAW_LEN        2
+#define DRAW_HEAD       DRAW_BASE
+#define DRAW_STATUS     (DRAW_BASE + 1)
+#define DRAW_RING_LEN   128
+#define DRAW_TAIL       (DRAW_RING + DRAW_RING_LEN)
+
+#define DRAW_BUSY       0x80    // commands queued or being drawn
+#define DRAW_OVERFLOW   0x40    // DRAW_HEAD passed DRAW_TAIL, the queue was dropped
+#define DRAW_UNFILLED   0x20    // a DRAW_FLOOD area was too complex to fill completely
+
+#define DRAW_COLOUR     0x01    // c                     colour to draw with
+#define DRAW_PAGE       0x02    // p                     page of video memory to draw into
+#define DRAW_CLEAR      0x03    //                       fill the screen
+#define DRAW_POINT      0x04    // x y
+#define DRAW_LINE       0x05    // x0 y0 x1 y1
+#define DRAW_BOX        0x06    // x0 y0 x1 y1           outline of a rectangle
+#define DRAW_RECT       0x07    // x0 y0 x1 y1           filled rectangle
+#define DRAW_CIRCLE     0x08    // x y r                 outline of a circle
+#define DRAW_DISC       0x09    // x y r                 filled circle
+#define DRAW_TRIANGLE   0x0A    // x0 y0 x1 y1 x2 y2     filled triangle
+#define DRAW_POLYGON    0x0B    // n x0 y0 ... xn-1 yn-1 filled polygon of 3 to 16 points
+#define DRAW_FLOOD      0x0C    // x y                   fill the area of x, y's colour
+
+#define DRAW_MAX_POINTS 16
+
+// Extended video memory. Built with EXT_VRAM=1 the Pico has EXT_VRAM_SIZE bytes of
+// video memory of its own, seen by the 6502 through a window of EXT_WINDOW_SIZE bytes
+// at EXT_WINDOW.
+//  EXT_BANK    bank of extended memory in the window, in EXT_WINDOW_SIZE units, in
+//              bits 0-5. Bit 6 reads as 1 once the window holds the bank.
+//  EXT_CTRL    bit 7 displays extended memory instead of the 6502's video memory,
+//              PAGE_DISPLAY then counts pages from the start of extended memory
+// Writes to the window go straight to extended memory, so they are on the screen at
+// once. Selecting a bank fills the window from it, which takes the Pico a few
+// microseconds, and the fill would overwrite anything written to the window before
+// it. After writing EXT_BANK, wait until it reads back with EXT_BANK_READY set before
+// reading or writing the window. Banks with EXT_BANK_BITMAP set are Pico memory for the
+// bitmap and the sprite patterns rather than video memory.
+#define EXT_WINDOW_SIZE 0x400
+#define EXT_DISPLAY     0x80
+#define EXT_BANK_READY  0x40
+#define EXT_BANK_NUMBER 0x3F
+
+// Bitmap mode, built with BITMAP_MODE=1. Bit 6 of COL80_BASE shows a 256x192 bitmap of
+// 16 colours, two pixels a byte with the left one in the high nibble, from memory in
+// the Pico. It is written through the extended memory window, selecting bank n of it
+// with EXT_BANK_BITMAP | n. The bitmap isn't copied into the frame snapshot, so changes
+// show as soon as they are made.
+#define EXT_BANK_BITMAP 0x80
+#define BITMAP_WIDTH    256
+#define BITMAP_HEIGHT   192
+#define BITMAP_SIZE     (BITMAP_WIDTH * BITMAP_HEIGHT / 2)
+
+// The sprite patterns, after the bitmap's banks
+#define EXT_BANK_SPRITES 0xA0
+
+// Palette registers, the colours of every mode. The 80 column modes use entries 0 to 7
+// and the bitmap all 16. The 6847 colours, the artifact colours and the colours the
+// FG/BG commands select are entries 2 green, 6 yellow, 1 blue, 4 red, 7 white, 3 cyan,
+// 5 magenta, 14 orange and 0 black.
+//  +n  the colour of entry n, for n from 0 to 15
+// A colour is the high byte of a scanvideo pixel, bits 2-3 red, 4-5 green and 6-7
+// blue. The entries are read back as written and are read by the Pico when it latches
+// a frame, so changes are seen from the next frame.
+#define PALETTE_ENTRIES 16
+#define PALETTE_LEN     PALETTE_ENTRIES
+
+// Render statistics registers, refreshed once a second by print_stats()
+//  +0      path to show, see enum render_path, write with bit 7 set to clear the
+//          histograms and maximum times
+//  +1      number of render paths
+//  +2      histogram bucket width in us
+//  +3      number of buckets
+//  +4..7   scanlines dropped since boot
+//  +8..11  scanlines that took longer than a scanline to render since boot
+//  +12..13 scanlines of the path in the last second
+//  +14..15 longest render time of the path in us
+//  +16..47 the path's histogram for the last second, 16 bit counts
+// Multi-byte values are little endian.
+#define STATS_LEN       48
+#define STATS_SELECT    STATS_BASE
+#define STATS_PATHS     (STATS_BASE + 1)
+#define STATS_BUCKET_US (STATS_BASE + 2)
+#define STATS_BUCKETS   (STATS_BASE + 3)
+#define STATS_DROPPED   (STATS_BASE + 4)
+#define STATS_LATE      (STATS_BASE + 8)
+#define STATS_LINES     (STATS_BASE + 12)
+#define STATS_MAX_US    (STATS_BASE + 14)
+#define STATS_HIST      (STATS_BASE + 16)
 
 #endif
@@ -180,8 +180,12 @@ static inline uint16_t sc_voc_next_sample(int index)
     return result;
 }
 
+// Time spent generating samples, for the audio load in print_stats()
+volatile uint32_t sc_busy_us = 0;
+
 bool sc_timer_callback(struct repeating_timer *t)
 {
+    uint32_t start = time_us_32();
     static int sample;
     pwm_set_gpio_level(SC_PIN, sample);
 
@@ -193,6 +197,7 @@ bool sc_timer_callback(struct repeating_timer *t)
         sample += sc_voc_next_sample(2);
     }
     sample = sample >> 6;
+    sc_busy_us += time_us_32() - start;
     return true;
 }
 